@@ -0,0 +1,281 @@
+#ifndef GENERATORS_H
+#define GENERATORS_H
+
+#include <vector>
+#include <string>
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <stdexcept>
+#include "graph.h"
+#include "graph_builder.h"
+
+// Synthetic max flow instances for benchmarking. Every generator takes a
+// target vertex count and a seed, and returns the same graph for the same
+// arguments.
+
+namespace Generators
+{
+    using Random = std::mt19937;
+
+    inline int uniform(Random &random, int low, int high)
+    {
+        return std::uniform_int_distribution<int>(low, high)(random);
+    }
+
+    // Picks count distinct values from [0, range)
+    inline std::vector<int> sample(Random &random, int range, int count)
+    {
+        std::vector<int> picked;
+        count = std::min(count, range);
+        while (static_cast<int>(picked.size()) < count)
+        {
+            int value = uniform(random, 0, range - 1);
+            if (std::find(picked.begin(), picked.end(), value) == picked.end())
+                picked.push_back(value);
+        }
+        return picked;
+    }
+
+    // Goldfarb and Grigoriadis' RMF networks (genrmf): b frames of a x a
+    // grids. Arcs inside a frame connect grid neighbours both ways with
+    // capacity c2 * a * a. Arcs from a frame to the next connect its vertices
+    // to a random permutation of the next frame, with capacities in [c1, c2].
+    inline Graph<int, int> rmf(int vertices, unsigned seed)
+    {
+        Random random(seed);
+        const int a = std::max(2, static_cast<int>(std::round(std::cbrt(vertices / 2.0))));
+        const int b = std::max(2, vertices / (a * a));
+        const int c1 = 1;
+        const int c2 = 1000;
+        const int frame = a * a;
+
+        GraphBuilder<int, int> builder(frame * b, 0, frame * b - 1);
+        for (int f{0}; f < b; ++f)
+        {
+            for (int y{0}; y < a; ++y)
+            {
+                for (int x{0}; x < a; ++x)
+                {
+                    int v = f * frame + y * a + x;
+                    if (x + 1 < a)
+                    {
+                        builder.addArc(v, v + 1, c2 * frame);
+                        builder.addArc(v + 1, v, c2 * frame);
+                    }
+                    if (y + 1 < a)
+                    {
+                        builder.addArc(v, v + a, c2 * frame);
+                        builder.addArc(v + a, v, c2 * frame);
+                    }
+                }
+            }
+
+            if (f + 1 < b)
+            {
+                std::vector<int> permutation(frame);
+                std::iota(permutation.begin(), permutation.end(), 0);
+                std::shuffle(permutation.begin(), permutation.end(), random);
+                for (int i{0}; i < frame; ++i)
+                {
+                    builder.addArc(f * frame + i, (f + 1) * frame + permutation[i], uniform(random, c1, c2));
+                }
+            }
+        }
+        return builder.build();
+    }
+
+    // Washington random level graphs: the vertices form levels of equal
+    // size, and every vertex has arcs to three random vertices of the next
+    // level. The source feeds the first level and the last level drains
+    // into the sink.
+    inline Graph<int, int> washington(int vertices, unsigned seed)
+    {
+        Random random(seed);
+        const int width = std::max(1, static_cast<int>(std::sqrt(vertices)));
+        const int levels = std::max(2, vertices / width);
+        const int source = width * levels;
+        const int sink = source + 1;
+
+        GraphBuilder<int, int> builder(width * levels + 2, source, sink);
+        for (int i{0}; i < width; ++i)
+        {
+            builder.addArc(source, i, uniform(random, 1, 10000));
+            builder.addArc((levels - 1) * width + i, sink, uniform(random, 1, 10000));
+        }
+
+        for (int level{0}; level + 1 < levels; ++level)
+        {
+            for (int i{0}; i < width; ++i)
+            {
+                for (int j : sample(random, width, 3))
+                {
+                    builder.addArc(level * width + i, (level + 1) * width + j, uniform(random, 1, 10000));
+                }
+            }
+        }
+        return builder.build();
+    }
+
+    // Instances in the style of Cherkassky and Goldberg's AK family, which
+    // are hard for both push-relabel and augmenting path algorithms. One part
+    // is a path whose capacities decrease by one per arc, with a unit arc to
+    // the sink from every path vertex, so the excess is pushed along the
+    // path in ever smaller amounts. The other part is k disjoint paths from
+    // the source to the sink of lengths 1 to k, which are found in k phases.
+    inline Graph<int, int> ak(int vertices, unsigned seed)
+    {
+        (void)seed;
+        const int k = std::max(2, static_cast<int>(std::sqrt(2.0 * vertices)) - 1);
+        const int source = 0;
+        const int sink = 1;
+        int next = 2;
+
+        GraphBuilder<int, int> builder(2 + k + k * (k + 1) / 2, source, sink);
+
+        int previous = source;
+        for (int i{0}; i < k; ++i)
+        {
+            int v = next++;
+            builder.addArc(previous, v, k - i);
+            builder.addArc(v, sink, 1);
+            previous = v;
+        }
+
+        for (int length{1}; length <= k; ++length)
+        {
+            previous = source;
+            for (int i{0}; i < length; ++i)
+            {
+                int v = next++;
+                builder.addArc(previous, v, 1);
+                previous = v;
+            }
+            builder.addArc(previous, sink, 1);
+        }
+        return builder.build();
+    }
+
+    // Vision grids as in image segmentation: every pixel has arcs from the
+    // source and to the sink, and arcs both ways to its neighbours along
+    // each dimension.
+    inline Graph<int, int> grid(const std::vector<int> &sides, unsigned seed)
+    {
+        Random random(seed);
+        int pixels{1};
+        for (int side : sides)
+            pixels *= side;
+        const int source = pixels;
+        const int sink = pixels + 1;
+
+        GraphBuilder<int, int> builder(pixels + 2, source, sink);
+        for (int p{0}; p < pixels; ++p)
+        {
+            builder.addArc(source, p, uniform(random, 0, 20));
+            builder.addArc(p, sink, uniform(random, 0, 20));
+
+            int stride{1};
+            int rest = p;
+            for (int side : sides)
+            {
+                if (rest % side + 1 < side)
+                {
+                    builder.addArc(p, p + stride, uniform(random, 1, 10));
+                    builder.addArc(p + stride, p, uniform(random, 1, 10));
+                }
+                rest /= side;
+                stride *= side;
+            }
+        }
+        return builder.build();
+    }
+
+    inline Graph<int, int> grid2d(int vertices, unsigned seed)
+    {
+        int side = std::max(2, static_cast<int>(std::sqrt(vertices)));
+        return grid({side, side}, seed);
+    }
+
+    inline Graph<int, int> grid3d(int vertices, unsigned seed)
+    {
+        int side = std::max(2, static_cast<int>(std::round(std::cbrt(vertices))));
+        return grid({side, side, side}, seed);
+    }
+
+    // Bipartite matching: every left vertex has unit arcs to eight random
+    // right vertices, the source has unit arcs to the left side and the right
+    // side has unit arcs to the sink.
+    inline Graph<int, int> bipartite(int vertices, unsigned seed)
+    {
+        Random random(seed);
+        const int side = std::max(1, vertices / 2);
+        const int source = 2 * side;
+        const int sink = source + 1;
+
+        GraphBuilder<int, int> builder(2 * side + 2, source, sink);
+        for (int i{0}; i < side; ++i)
+        {
+            builder.addArc(source, i, 1);
+            builder.addArc(side + i, sink, 1);
+            for (int j : sample(random, side, 8))
+            {
+                builder.addArc(i, side + j, 1);
+            }
+        }
+        return builder.build();
+    }
+
+    // Layered graphs of high degree: the source has arcs to the first
+    // layer, every vertex has arcs to 64 random vertices of the next layer,
+    // and the last layer has arcs to the sink. Push-relabel spends most of
+    // its time scanning the long arc lists of these vertices.
+    inline Graph<int, int> dense(int vertices, unsigned seed)
+    {
+        Random random(seed);
+        const int width = 256;
+        const int degree = 64;
+        const int layers = std::max(2, vertices / width);
+        const int source = layers * width;
+        const int sink = source + 1;
+
+        GraphBuilder<int, int> builder(layers * width + 2, source, sink);
+        for (int i{0}; i < width; ++i)
+        {
+            builder.addArc(source, i, uniform(random, 1, 100 * degree));
+            builder.addArc((layers - 1) * width + i, sink, uniform(random, 1, 100 * degree));
+        }
+        for (int layer{0}; layer + 1 < layers; ++layer)
+        {
+            for (int i{0}; i < width; ++i)
+            {
+                for (int j : sample(random, width, degree))
+                    builder.addArc(layer * width + i, (layer + 1) * width + j, uniform(random, 1, 100));
+            }
+        }
+        return builder.build();
+    }
+
+    struct Family
+    {
+        std::string name;
+        std::function<Graph<int, int>(int, unsigned)> generate;
+    };
+
+    inline const std::vector<Family> &families()
+    {
+        static const std::vector<Family> all{
+            {"rmf", rmf},
+            {"washington", washington},
+            {"ak", ak},
+            {"grid2d", grid2d},
+            {"grid3d", grid3d},
+            {"bipartite", bipartite},
+            {"dense", dense},
+        };
+        return all;
+    }
+}
+
+#endif // GENERATORS_H
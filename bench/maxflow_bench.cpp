@@ -0,0 +1,342 @@
+
+#include "generators.h"
+#include "solver.h"
+#include "reorder.h"
+#include "types.h"
+#include "arc_scan.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+
+// Benchmarks every algorithm on the synthetic instance families, over a
+// sweep of sizes. Every run solves the same instance, which solvers do not
+// change. The max flow values of the algorithms are compared, and a
+// mismatch makes the benchmark fail.
+//
+// The generators number the vertices in the order they build them, which
+// is already local. --shuffle numbers them at random instead, as in a DIMACS
+// file from an arbitrary source, and --reorder renumbers the instance before
+// the runs, to measure what the reordering recovers.
+//
+// --scan lowers the instruction set of the arc scans of push-relabel, to
+// compare the vector kernels with the scalar ones on the same instances.
+
+struct BenchOptions
+{
+    bool json{false};
+    int warmup{1};
+    int repeats{5};
+    int levels{2};
+    unsigned seed{1};
+    bool shuffle{false};
+    VertexOrder vertexOrder{VertexOrder::none};
+    std::vector<std::string> families;
+    std::vector<AlgorithmEnums::Algorithm> algorithms;
+    SolverOptions solverOptions;
+};
+
+struct BenchResult
+{
+    std::string family;
+    int level;
+    int vertices;
+    int arcs;
+    AlgorithmEnums::Algorithm algorithm;
+    long long flow;
+    double medianMicroseconds;
+    double p95Microseconds;
+    double arcsPerSecond;
+    double reorderMicroseconds;
+};
+
+void printUsage(std::string_view program)
+{
+    std::cerr << "usage: " << program << " [options]\n\n"
+              << "--format <csv|json>\tOutput format (default: csv)\n"
+              << "--warmup <n>\t\tUntimed runs before the timed runs (default: 1)\n"
+              << "--repeats <n>\t\tTimed runs per algorithm and instance (default: 5)\n"
+              << "--levels <n>\t\tSize levels to sweep. Level l has about 1000 * 4^(l - 1) vertices (default: 2)\n"
+              << "--family <name>\t\tOnly run this family, may be repeated [rmf, washington, ak, grid2d, grid3d, bipartite, dense]\n"
+              << "--algorithm <name>\tOnly run this algorithm, may be repeated (default: all). auto is reported as the solver it ran\n"
+              << "--seed <n>\t\tSeed of the generators (default: 1)\n"
+              << "-t,--threads <n>\tNumber of threads used by prpar and the BFS of ek, dinic and hipr (default: one per hardware\n"
+              << "\t\t\tthread for prpar, one for the BFS)\n"
+              << "--shuffle\t\tNumber the vertices of every instance at random\n"
+              << "--reduce\t\tReduce every instance before each run, as part of the timed run\n"
+              << "--reorder <order>\tRenumber the vertices of every instance before the runs [bfs, rcm, degree, none]\n"
+              << "--scan <level>\t\tInstruction set of the arc scans of pr and hipr [scalar, avx2, avx512] (default: the best the CPU has)\n"
+              << "-h,--help\t\tShow this help message"
+              << std::endl;
+}
+
+int parsePositive(const std::string &option, const std::string &value, int minimum)
+{
+    std::size_t parsed{0};
+    int number{0};
+    try
+    {
+        number = std::stoi(value, &parsed);
+    }
+    catch (const std::exception &)
+    {
+        parsed = 0;
+    }
+
+    if (parsed != value.size() || number < minimum)
+    {
+        throw std::invalid_argument(option + " must be an integer of at least " + std::to_string(minimum) + ", got " + value);
+    }
+    return number;
+}
+
+// Instruction sets above the one of the CPU are rejected
+ArcScan::SimdLevel parseSimdLevel(const std::string &value)
+{
+    const std::string names[] = {"scalar", "avx2", "avx512"};
+    auto found = std::find(std::begin(names), std::end(names), value);
+    if (found == std::end(names))
+        throw std::invalid_argument("Unknown scan level " + value);
+
+    auto level = static_cast<ArcScan::SimdLevel>(found - std::begin(names));
+    if (level > ArcScan::detectSimdLevel())
+        throw std::invalid_argument("This CPU does not support " + value);
+    return level;
+}
+
+BenchOptions parseOptions(int argc, char *argv[])
+{
+    BenchOptions options;
+
+    for (int i{1}; i < argc; ++i)
+    {
+        std::string arg{argv[i]};
+        if (arg == "-h" || arg == "--help")
+        {
+            printUsage(argv[0]);
+            std::exit(EXIT_SUCCESS);
+        }
+
+        if (arg == "--shuffle")
+        {
+            options.shuffle = true;
+            continue;
+        }
+        if (arg == "--reduce")
+        {
+            options.solverOptions.reduce = true;
+            continue;
+        }
+
+        if (++i == argc)
+        {
+            throw std::invalid_argument(arg + " requires a value");
+        }
+        std::string value{argv[i]};
+
+        if (arg == "--format")
+        {
+            if (value != "csv" && value != "json")
+                throw std::invalid_argument("Unknown format " + value);
+            options.json = value == "json";
+        }
+        else if (arg == "--warmup")
+            options.warmup = parsePositive(arg, value, 0);
+        else if (arg == "--repeats")
+            options.repeats = parsePositive(arg, value, 1);
+        else if (arg == "--levels")
+            options.levels = parsePositive(arg, value, 1);
+        else if (arg == "--seed")
+            options.seed = parsePositive(arg, value, 0);
+        else if (arg == "-t" || arg == "--threads")
+            options.solverOptions.threadCount = parsePositive(arg, value, 1);
+        else if (arg == "--reorder")
+            options.vertexOrder = stringToVertexOrder(value);
+        else if (arg == "--scan")
+            ArcScan::simdLevel = parseSimdLevel(value);
+        else if (arg == "--algorithm")
+            options.algorithms.push_back(AlgorithmEnums::stringToEnum(value));
+        else if (arg == "--family")
+        {
+            const auto &families = Generators::families();
+            auto found = std::find_if(families.begin(), families.end(), [&value](const Generators::Family &family)
+                                      { return family.name == value; });
+            if (found == families.end())
+                throw std::invalid_argument("Unknown family " + value);
+            options.families.push_back(value);
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option " + arg);
+        }
+    }
+
+    if (options.algorithms.empty())
+    {
+        options.algorithms.assign(std::begin(AlgorithmEnums::allAlgorithms), std::end(AlgorithmEnums::allAlgorithms));
+    }
+    return options;
+}
+
+// Value at the given fraction of the sorted samples, by the nearest rank
+double percentile(std::vector<double> samples, double fraction)
+{
+    std::sort(samples.begin(), samples.end());
+    std::size_t rank = static_cast<std::size_t>(std::ceil(fraction * samples.size()));
+    return samples[std::max<std::size_t>(rank, 1) - 1];
+}
+
+// Returns the graph with its vertices numbered at random
+Graph<int, int> shuffleVertices(const Graph<int, int> &graph, unsigned seed)
+{
+    std::vector<int> order(graph.V);
+    std::iota(order.begin(), order.end(), 0);
+    Generators::Random random(seed);
+    std::shuffle(order.begin(), order.end(), random);
+
+    VertexReordering<int> reordering;
+    return renumberVertices(graph, std::move(order), reordering);
+}
+
+BenchResult runBenchmark(const Graph<int, int> &instance, AlgorithmEnums::Algorithm algorithm, const BenchOptions &options)
+{
+    BenchResult result{};
+    result.algorithm = algorithm;
+    std::vector<double> times;
+
+    for (int run{0}; run < options.warmup + options.repeats; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        result.flow = findMaxFlow(algorithm, instance, options.solverOptions);
+        auto end = std::chrono::steady_clock::now();
+
+        if (run >= options.warmup)
+            times.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    result.medianMicroseconds = percentile(times, 0.5);
+    result.p95Microseconds = percentile(times, 0.95);
+    result.arcsPerSecond = instance.E / (result.medianMicroseconds * 1e-6);
+    return result;
+}
+
+void printCsvHeader()
+{
+    std::cout << "family,level,vertices,arcs,algorithm,flow,median_us,p95_us,arcs_per_second,reorder_us\n";
+}
+
+void printCsv(const BenchResult &result)
+{
+    std::cout << result.family << ',' << result.level << ',' << result.vertices << ',' << result.arcs << ','
+              << AlgorithmEnums::enumToString(result.algorithm) << ',' << result.flow << ','
+              << result.medianMicroseconds << ',' << result.p95Microseconds << ',' << result.arcsPerSecond << ','
+              << result.reorderMicroseconds << '\n';
+}
+
+void printJson(const std::vector<BenchResult> &results)
+{
+    std::cout << "[\n";
+    for (std::size_t i{0}; i < results.size(); ++i)
+    {
+        const auto &result = results[i];
+        std::cout << "  {\"family\": \"" << result.family << "\", \"level\": " << result.level
+                  << ", \"vertices\": " << result.vertices << ", \"arcs\": " << result.arcs
+                  << ", \"algorithm\": \"" << AlgorithmEnums::enumToString(result.algorithm) << "\""
+                  << ", \"flow\": " << result.flow
+                  << ", \"median_us\": " << result.medianMicroseconds
+                  << ", \"p95_us\": " << result.p95Microseconds
+                  << ", \"arcs_per_second\": " << result.arcsPerSecond
+                  << ", \"reorder_us\": " << result.reorderMicroseconds << "}"
+                  << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    std::cout << "]" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchOptions options;
+    try
+    {
+        options = parseOptions(argc, argv);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    bool mismatch{false};
+    std::vector<BenchResult> results;
+    std::cout << std::fixed << std::setprecision(1);
+    if (!options.json)
+        printCsvHeader();
+
+    for (const auto &family : Generators::families())
+    {
+        if (!options.families.empty() &&
+            std::find(options.families.begin(), options.families.end(), family.name) == options.families.end())
+            continue;
+
+        for (int level{1}; level <= options.levels; ++level)
+        {
+            int vertices = 1000 << (2 * (level - 1));
+            unsigned seed = options.seed + level;
+            const Graph<int, int> generated = options.shuffle ? shuffleVertices(family.generate(vertices, seed), seed)
+                                                              : family.generate(vertices, seed);
+
+            VertexReordering<int> reordering;
+            auto start = std::chrono::steady_clock::now();
+            const Graph<int, int> instance = options.vertexOrder == VertexOrder::none
+                                                 ? generated
+                                                 : reorderVertices(generated, options.vertexOrder, reordering, options.solverOptions.threadCount);
+            auto end = std::chrono::steady_clock::now();
+            double reorderMicroseconds = options.vertexOrder == VertexOrder::none
+                                             ? 0
+                                             : std::chrono::duration<double, std::micro>(end - start).count();
+
+            long long expectedFlow{-1};
+            for (auto requested : options.algorithms)
+            {
+                // Every result is named after the solver that ran
+                auto algorithm = resolveAlgorithm(requested, instance);
+
+                // The unit capacity solver only runs on some families
+                if (algorithm == AlgorithmEnums::Algorithm::unit && !isUnitCapacity(instance))
+                    continue;
+
+                BenchResult result = runBenchmark(instance, algorithm, options);
+                result.family = family.name;
+                result.level = level;
+                result.vertices = instance.V;
+                result.arcs = instance.E;
+                result.reorderMicroseconds = reorderMicroseconds;
+
+                if (expectedFlow == -1)
+                    expectedFlow = result.flow;
+                else if (result.flow != expectedFlow)
+                {
+                    std::cerr << "Error: " << AlgorithmEnums::enumToString(algorithm) << " found flow " << result.flow
+                              << " on " << family.name << " level " << level << ", expected " << expectedFlow << '\n';
+                    mismatch = true;
+                }
+
+                if (options.json)
+                    results.push_back(result);
+                else
+                    printCsv(result);
+            }
+        }
+    }
+
+    if (options.json)
+        printJson(results);
+
+    return mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,250 @@
+#ifndef ARC_SCAN_H
+#define ARC_SCAN_H
+
+#include <type_traits>
+#include <algorithm>
+
+// Scans of the arcs of a vertex for the relabels of push-relabel: the
+// lowest residual neighbour, and the first arc to a neighbour of a given
+// height. Both gather the heights of the heads of the arcs, masked by their
+// residual capacity.
+//
+// A relabel reads every arc of its vertex, so the scans pay off on vertices
+// of high degree. Discharges stay scalar: their current arc is mostly
+// admissible or close to one, and a vector would gather the heights of the
+// arcs past it for nothing.
+//
+// On x86 with GCC or Clang, arcs are scanned 16 at a time with AVX-512 or 8
+// at a time with AVX2, chosen at runtime from the features of the CPU.
+// Vectors are used for 32-bit vertex ids and heights with int, long long or
+// double capacities, and for vertices with at least simdDegree arcs. All
+// other scans, and all scans elsewhere, are scalar.
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define MAXFLOW_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace ArcScan
+{
+    enum class SimdLevel
+    {
+        scalar,
+        avx2,
+        avx512,
+    };
+
+    inline SimdLevel detectSimdLevel()
+    {
+#ifdef MAXFLOW_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return SimdLevel::avx512;
+        if (__builtin_cpu_supports("avx2"))
+            return SimdLevel::avx2;
+#endif
+        return SimdLevel::scalar;
+    }
+
+    // The instruction set used by the scans. It may be lowered, to compare
+    // the kernels, but only while no solver runs.
+    inline SimdLevel simdLevel = detectSimdLevel();
+
+    // Vertices with fewer arcs are scanned one arc at a time
+    constexpr int simdDegree = 16;
+
+    // Returns the first arc e in [first, end) with capacities[e] > 0 and
+    // heights[heads[e]] == height, or end if there is none
+    template <typename I, typename U, typename H>
+    I findAdmissibleArcScalar(const I *heads, const U *capacities, const H *heights, I first, I end, H height)
+    {
+        for (I e = first; e < end; ++e)
+        {
+            if (capacities[e] > 0 && heights[heads[e]] == height)
+                return e;
+        }
+        return end;
+    }
+
+    // Returns the lowest height of a head of an arc in [first, end) with
+    // residual capacity, capped at none. Returns none if there is no such arc.
+    template <typename I, typename U, typename H>
+    H minResidualHeightScalar(const I *heads, const U *capacities, const H *heights, I first, I end, H none)
+    {
+        H minHeight = none;
+        for (I e = first; e < end; ++e)
+        {
+            if (capacities[e] > 0)
+                minHeight = std::min(minHeight, heights[heads[e]]);
+        }
+        return minHeight;
+    }
+
+#ifdef MAXFLOW_X86_SIMD
+    template <typename U>
+    constexpr bool hasSimdCapacity = std::is_same<U, int>::value || std::is_same<U, long long>::value || std::is_same<U, double>::value;
+
+    // Bit i is set if capacities[i] > 0, for 8 capacities
+    __attribute__((target("avx2"))) inline unsigned residualBits8(const int *capacities)
+    {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(capacities));
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(c, _mm256_setzero_si256())));
+    }
+
+    __attribute__((target("avx2"))) inline unsigned residualBits8(const long long *capacities)
+    {
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(capacities));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(capacities + 4));
+        unsigned lowBits = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(low, _mm256_setzero_si256())));
+        unsigned highBits = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(high, _mm256_setzero_si256())));
+        return lowBits | highBits << 4;
+    }
+
+    __attribute__((target("avx2"))) inline unsigned residualBits8(const double *capacities)
+    {
+        __m256d low = _mm256_cmp_pd(_mm256_loadu_pd(capacities), _mm256_setzero_pd(), _CMP_GT_OQ);
+        __m256d high = _mm256_cmp_pd(_mm256_loadu_pd(capacities + 4), _mm256_setzero_pd(), _CMP_GT_OQ);
+        return _mm256_movemask_pd(low) | _mm256_movemask_pd(high) << 4;
+    }
+
+    // Lanes of 8 bits, all ones where the bit is set
+    __attribute__((target("avx2"))) inline __m256i laneMask8(unsigned bits)
+    {
+        const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits), laneBits), laneBits);
+    }
+
+    template <typename U>
+    __attribute__((target("avx2"))) int findAdmissibleArcAvx2(const int *heads, const U *capacities, const int *heights, int first, int end, int height)
+    {
+        const __m256i target = _mm256_set1_epi32(height);
+        int e = first;
+        for (; e + 8 <= end; e += 8)
+        {
+            unsigned residual = residualBits8(capacities + e);
+            if (residual == 0)
+                continue;
+            __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(heads + e));
+            __m256i h = _mm256_mask_i32gather_epi32(target, heights, index, laneMask8(residual), 4);
+            unsigned match = residual & _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(h, target)));
+            if (match != 0)
+                return e + __builtin_ctz(match);
+        }
+        return findAdmissibleArcScalar(heads, capacities, heights, e, end, height);
+    }
+
+    template <typename U>
+    __attribute__((target("avx2"))) int minResidualHeightAvx2(const int *heads, const U *capacities, const int *heights, int first, int end, int none)
+    {
+        const __m256i noneVector = _mm256_set1_epi32(none);
+        __m256i minimum = noneVector;
+        int e = first;
+        for (; e + 8 <= end; e += 8)
+        {
+            unsigned residual = residualBits8(capacities + e);
+            if (residual == 0)
+                continue;
+            __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(heads + e));
+            minimum = _mm256_min_epi32(minimum, _mm256_mask_i32gather_epi32(noneVector, heights, index, laneMask8(residual), 4));
+        }
+
+        // Horizontal minimum of the 8 lanes
+        __m128i m = _mm_min_epi32(_mm256_castsi256_si128(minimum), _mm256_extracti128_si256(minimum, 1));
+        m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+        m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+        return std::min(_mm_cvtsi128_si32(m), minResidualHeightScalar(heads, capacities, heights, e, end, none));
+    }
+
+    // Mask of capacities[i] > 0, for 16 capacities
+    __attribute__((target("avx512f"))) inline __mmask16 residualMask16(const int *capacities)
+    {
+        return _mm512_cmpgt_epi32_mask(_mm512_loadu_si512(capacities), _mm512_setzero_si512());
+    }
+
+    __attribute__((target("avx512f"))) inline __mmask16 residualMask16(const long long *capacities)
+    {
+        __mmask8 low = _mm512_cmpgt_epi64_mask(_mm512_loadu_si512(capacities), _mm512_setzero_si512());
+        __mmask8 high = _mm512_cmpgt_epi64_mask(_mm512_loadu_si512(capacities + 8), _mm512_setzero_si512());
+        return static_cast<__mmask16>(low | high << 8);
+    }
+
+    __attribute__((target("avx512f"))) inline __mmask16 residualMask16(const double *capacities)
+    {
+        __mmask8 low = _mm512_cmp_pd_mask(_mm512_loadu_pd(capacities), _mm512_setzero_pd(), _CMP_GT_OQ);
+        __mmask8 high = _mm512_cmp_pd_mask(_mm512_loadu_pd(capacities + 8), _mm512_setzero_pd(), _CMP_GT_OQ);
+        return static_cast<__mmask16>(low | high << 8);
+    }
+
+    template <typename U>
+    __attribute__((target("avx512f"))) int findAdmissibleArcAvx512(const int *heads, const U *capacities, const int *heights, int first, int end, int height)
+    {
+        const __m512i target = _mm512_set1_epi32(height);
+        int e = first;
+        for (; e + 16 <= end; e += 16)
+        {
+            __mmask16 residual = residualMask16(capacities + e);
+            if (residual == 0)
+                continue;
+            __m512i index = _mm512_loadu_si512(heads + e);
+            __m512i h = _mm512_mask_i32gather_epi32(target, residual, index, heights, 4);
+            unsigned match = _mm512_mask_cmpeq_epi32_mask(residual, h, target);
+            if (match != 0)
+                return e + __builtin_ctz(match);
+        }
+        return findAdmissibleArcScalar(heads, capacities, heights, e, end, height);
+    }
+
+    template <typename U>
+    __attribute__((target("avx512f"))) int minResidualHeightAvx512(const int *heads, const U *capacities, const int *heights, int first, int end, int none)
+    {
+        const __m512i noneVector = _mm512_set1_epi32(none);
+        __m512i minimum = noneVector;
+        int e = first;
+        for (; e + 16 <= end; e += 16)
+        {
+            __mmask16 residual = residualMask16(capacities + e);
+            if (residual == 0)
+                continue;
+            __m512i index = _mm512_loadu_si512(heads + e);
+            minimum = _mm512_mask_min_epi32(minimum, residual, minimum, _mm512_mask_i32gather_epi32(noneVector, residual, index, heights, 4));
+        }
+
+        // The lanes are reduced in memory: the reduction intrinsics of GCC
+        // 12 warn about their undefined lanes
+        alignas(64) int lanes[16];
+        _mm512_store_si512(lanes, minimum);
+        return std::min(*std::min_element(lanes, lanes + 16), minResidualHeightScalar(heads, capacities, heights, e, end, none));
+    }
+#endif
+
+    template <typename I, typename U, typename H>
+    I findAdmissibleArc(const I *heads, const U *capacities, const H *heights, I first, I end, H height)
+    {
+#ifdef MAXFLOW_X86_SIMD
+        if constexpr (std::is_same<I, int>::value && std::is_same<H, int>::value && hasSimdCapacity<U>)
+        {
+            if (end - first >= simdDegree && simdLevel == SimdLevel::avx512)
+                return findAdmissibleArcAvx512(heads, capacities, heights, first, end, height);
+            if (end - first >= simdDegree && simdLevel == SimdLevel::avx2)
+                return findAdmissibleArcAvx2(heads, capacities, heights, first, end, height);
+        }
+#endif
+        return findAdmissibleArcScalar(heads, capacities, heights, first, end, height);
+    }
+
+    template <typename I, typename U, typename H>
+    H minResidualHeight(const I *heads, const U *capacities, const H *heights, I first, I end, H none)
+    {
+#ifdef MAXFLOW_X86_SIMD
+        if constexpr (std::is_same<I, int>::value && std::is_same<H, int>::value && hasSimdCapacity<U>)
+        {
+            if (end - first >= simdDegree && simdLevel == SimdLevel::avx512)
+                return minResidualHeightAvx512(heads, capacities, heights, first, end, none);
+            if (end - first >= simdDegree && simdLevel == SimdLevel::avx2)
+                return minResidualHeightAvx2(heads, capacities, heights, first, end, none);
+        }
+#endif
+        return minResidualHeightScalar(heads, capacities, heights, first, end, none);
+    }
+}
+
+#endif // ARC_SCAN_H
@@ -0,0 +1,316 @@
+#ifndef BINARY_GRAPH_H
+#define BINARY_GRAPH_H
+
+#include <string>
+#include <fstream>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include "graph.h"
+#include "mapped_file.h"
+
+// Binary graph format: a header followed by the CSR arrays of a built graph,
+// in native byte order. The sections offsets, heads, antiParallel and
+// capacities follow the header in that order, each padded to 8 bytes.
+// A file is loaded by mapping it and solving straight from the mapped
+// arrays, so loading costs page faults instead of parsing.
+struct BinaryGraphHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t indexSize;
+    std::uint32_t capacitySize;
+    std::uint32_t floatingCapacities;
+    std::uint32_t reserved;
+    std::uint64_t vertexCount;
+    std::uint64_t edgeCount;
+    std::uint64_t arcCount;
+    std::uint64_t source;
+    std::uint64_t sink;
+    std::uint64_t checksum;
+};
+
+namespace BinaryGraph
+{
+    constexpr char magic[8] = {'M', 'A', 'X', 'F', 'L', 'O', 'W', 'B'};
+    constexpr std::uint32_t version = 1;
+
+    // Reads back differently on a machine with the other byte order
+    constexpr std::uint32_t byteOrder = 0x01020304;
+
+    inline std::size_t padded(std::size_t bytes)
+    {
+        return (bytes + 7) / 8 * 8;
+    }
+
+    // Byte positions of the sections in a file
+    struct Layout
+    {
+        std::size_t offsets;
+        std::size_t heads;
+        std::size_t antiParallel;
+        std::size_t capacities;
+        std::size_t size;
+
+        Layout(const BinaryGraphHeader &header)
+        {
+            offsets = sizeof(BinaryGraphHeader);
+            heads = offsets + padded((header.vertexCount + 1) * header.indexSize);
+            antiParallel = heads + padded(header.arcCount * header.indexSize);
+            capacities = antiParallel + padded(header.arcCount * header.indexSize);
+            size = capacities + padded(header.arcCount * header.capacitySize);
+        }
+    };
+
+    // 64-bit checksum of the sections, read as 8-byte words with the last
+    // word of every section padded with zeros. Four lanes are mixed
+    // independently, so the multiplications of consecutive words overlap.
+    class Checksum
+    {
+    public:
+        void add(const void *data, std::size_t bytes)
+        {
+            const char *begin = static_cast<const char *>(data);
+            std::size_t words = bytes / 8;
+            for (std::size_t i = 0; i < words; ++i)
+            {
+                std::uint64_t word;
+                std::memcpy(&word, begin + 8 * i, 8);
+                addWord(word);
+            }
+
+            if (bytes % 8 != 0)
+            {
+                std::uint64_t word{0};
+                std::memcpy(&word, begin + 8 * words, bytes % 8);
+                addWord(word);
+            }
+        }
+
+        std::uint64_t value() const
+        {
+            return rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) +
+                   rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18) + wordCount;
+        }
+
+    private:
+        static constexpr std::uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+        static constexpr std::uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+
+        std::uint64_t lanes[4]{prime1, prime2, 0, ~prime1};
+        std::uint64_t wordCount{0};
+
+        static std::uint64_t rotateLeft(std::uint64_t x, int bits)
+        {
+            return (x << bits) | (x >> (64 - bits));
+        }
+
+        void addWord(std::uint64_t word)
+        {
+            std::uint64_t &lane = lanes[wordCount++ % 4];
+            lane = rotateLeft(lane + word * prime2, 31) * prime1;
+        }
+    };
+
+    // Returns true if the offsets ascend, every head is a vertex, and every
+    // arc e has an anti-parallel arc r with r's anti-parallel arc e, from the
+    // head of e to the tail of e. Those are what the solvers index with.
+    template <typename T>
+    bool isValid(const T *offsets, const T *heads, const T *antiParallel, std::uint64_t vertexCount)
+    {
+        auto at = [](const T *array, std::uint64_t i)
+        {
+            return static_cast<std::uint64_t>(array[i]);
+        };
+        for (std::uint64_t u = 0; u < vertexCount; ++u)
+        {
+            if (at(offsets, u) > at(offsets, u + 1))
+                return false;
+        }
+        for (std::uint64_t u = 0; u < vertexCount; ++u)
+        {
+            for (std::uint64_t e = at(offsets, u); e < at(offsets, u + 1); ++e)
+            {
+                const std::uint64_t v = at(heads, e);
+                const std::uint64_t r = at(antiParallel, e);
+                if (v >= vertexCount || r < at(offsets, v) || r >= at(offsets, v + 1) ||
+                    at(antiParallel, r) != e || at(heads, r) != u)
+                    return false;
+            }
+        }
+        return true;
+    }
+}
+
+// Returns true if the file at path starts like a binary graph.
+inline bool isBinaryGraph(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(BinaryGraph::magic)]{};
+    file.read(magic, sizeof(magic));
+    return file && std::memcmp(magic, BinaryGraph::magic, sizeof(magic)) == 0;
+}
+
+// Reads the header of a binary graph file, which gives the types of its arrays
+inline BinaryGraphHeader readBinaryGraphHeader(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("could not open or read from file " + path);
+    }
+
+    BinaryGraphHeader header;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file)
+    {
+        throw std::logic_error(path + ": the file is too short for a binary graph");
+    }
+    if (std::memcmp(header.magic, BinaryGraph::magic, sizeof(header.magic)) != 0)
+    {
+        throw std::logic_error(path + ": not a binary graph file");
+    }
+    return header;
+}
+
+// Writes the arc arrays of the graph to path in the binary graph format.
+template <typename T, typename U>
+void writeBinaryGraph(const Graph<T, U> &graph, const std::string &path)
+{
+    BinaryGraphHeader header{};
+    std::memcpy(header.magic, BinaryGraph::magic, sizeof(header.magic));
+    header.version = BinaryGraph::version;
+    header.byteOrder = BinaryGraph::byteOrder;
+    header.indexSize = sizeof(T);
+    header.capacitySize = sizeof(U);
+    header.floatingCapacities = std::is_floating_point<U>::value;
+    header.vertexCount = graph.V;
+    header.edgeCount = graph.E;
+    header.arcCount = graph.heads.size();
+    header.source = graph.source;
+    header.sink = graph.sink;
+
+    BinaryGraph::Checksum checksum;
+    checksum.add(graph.offsets.data(), graph.offsets.size() * sizeof(T));
+    checksum.add(graph.heads.data(), graph.heads.size() * sizeof(T));
+    checksum.add(graph.antiParallel.data(), graph.antiParallel.size() * sizeof(T));
+    checksum.add(graph.capacities.data(), graph.capacities.size() * sizeof(U));
+    header.checksum = checksum.value();
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("could not write to file " + path);
+    }
+
+    auto writeSection = [&file](const void *data, std::size_t bytes)
+    {
+        static const char zeros[8]{};
+        file.write(static_cast<const char *>(data), bytes);
+        file.write(zeros, BinaryGraph::padded(bytes) - bytes);
+    };
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    writeSection(graph.offsets.data(), graph.offsets.size() * sizeof(T));
+    writeSection(graph.heads.data(), graph.heads.size() * sizeof(T));
+    writeSection(graph.antiParallel.data(), graph.antiParallel.size() * sizeof(T));
+    writeSection(graph.capacities.data(), graph.capacities.size() * sizeof(U));
+
+    file.flush();
+    if (!file)
+    {
+        throw std::runtime_error("could not write to file " + path);
+    }
+}
+
+// Maps a binary graph file and returns a graph that uses the mapped arrays
+// directly. Solvers only read the arrays, so the pages stay shared with the
+// page cache. The mapping is copy-on-write, so the file is never modified
+// even if the graph is.
+//
+// Only the header, the file size and the ends of the offsets are checked, so
+// loading touches the pages the solver reads and no others. The arrays of an
+// unverified file are trusted: a corrupt file may hold heads or
+// anti-parallel arcs out of range, or offsets that decrease, and the solvers
+// would read out of bounds. With verify, the whole file is read, its
+// checksum is compared and the arrays are checked to form a graph.
+template <typename T, typename U>
+Graph<T, U> readBinaryGraph(const std::string &path, bool verify = false)
+{
+    auto file = std::make_shared<MappedFile>(path, true, verify ? MADV_WILLNEED : MADV_NORMAL);
+
+    BinaryGraphHeader header;
+    if (file->length() < sizeof(header))
+    {
+        throw std::logic_error(path + ": the file is too short for a binary graph");
+    }
+    std::memcpy(&header, file->begin(), sizeof(header));
+
+    if (std::memcmp(header.magic, BinaryGraph::magic, sizeof(header.magic)) != 0)
+    {
+        throw std::logic_error(path + ": not a binary graph file");
+    }
+    if (header.version != BinaryGraph::version)
+    {
+        throw std::logic_error(path + ": unsupported binary graph version " + std::to_string(header.version));
+    }
+    if (header.byteOrder != BinaryGraph::byteOrder)
+    {
+        throw std::logic_error(path + ": the file was written with a different byte order");
+    }
+    if (header.indexSize != sizeof(T) || header.capacitySize != sizeof(U) ||
+        header.floatingCapacities != std::is_floating_point<U>::value)
+    {
+        throw std::logic_error(path + ": the file has " + std::to_string(header.indexSize) +
+                               "-byte vertex ids and " + std::to_string(header.capacitySize) +
+                               "-byte capacities, which do not match the graph type");
+    }
+
+    // Bound the counts first, so the layout can not overflow
+    if (header.vertexCount >= file->length() || header.arcCount > file->length())
+    {
+        throw std::logic_error(path + ": the file size does not match its header");
+    }
+    BinaryGraph::Layout layout(header);
+    if (file->length() != layout.size)
+    {
+        throw std::logic_error(path + ": the file size does not match its header");
+    }
+
+    if (verify)
+    {
+        BinaryGraph::Checksum checksum;
+        checksum.add(file->begin() + layout.offsets, layout.size - layout.offsets);
+        if (checksum.value() != header.checksum)
+        {
+            throw std::logic_error(path + ": checksum mismatch, the file is corrupt");
+        }
+    }
+
+    char *data = file->mutableData();
+    T *offsets = reinterpret_cast<T *>(data + layout.offsets);
+    if (offsets[0] != 0 || static_cast<std::uint64_t>(offsets[header.vertexCount]) != header.arcCount ||
+        header.source >= header.vertexCount || header.sink >= header.vertexCount)
+    {
+        throw std::logic_error(path + ": the arc arrays are inconsistent with the header");
+    }
+    if (verify && !BinaryGraph::isValid(offsets,
+                                        reinterpret_cast<const T *>(data + layout.heads),
+                                        reinterpret_cast<const T *>(data + layout.antiParallel),
+                                        header.vertexCount))
+    {
+        throw std::logic_error(path + ": the arc arrays do not form a graph");
+    }
+
+    Graph<T, U> graph(header.vertexCount, header.edgeCount, header.source, header.sink);
+    graph.attach(offsets,
+                 reinterpret_cast<T *>(data + layout.heads),
+                 reinterpret_cast<U *>(data + layout.capacities),
+                 reinterpret_cast<T *>(data + layout.antiParallel),
+                 header.arcCount, std::move(file));
+    return graph;
+}
+
+#endif // BINARY_GRAPH_H
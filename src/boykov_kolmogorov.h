@@ -0,0 +1,357 @@
+#ifndef BOYKOV_KOLMOGOROV_H
+#define BOYKOV_KOLMOGOROV_H
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include "graph.h"
+
+// Boykov and Kolmogorov's algorithm, which does well on the grid graphs of
+// computer vision. Two search trees are grown, one from the source and one
+// from the sink, until they touch. After augmenting along the path found,
+// the trees are kept: vertices cut off by saturated arcs become orphans and
+// are adopted by a new parent in their tree or freed. The timestamp and
+// distance marks of Kolmogorov's implementation keep the trees shallow.
+//
+// Runs on a Graph, or on a GridGraph given as G.
+template <typename T, typename U, typename G = Graph<T, U>>
+class BoykovKolmogorov
+{
+public:
+    BoykovKolmogorov(const G &graph) : graph(graph), none(graph.V) {}
+
+    U findMaxFlow()
+    {
+        U maxflow{0};
+        initializeTrees();
+
+        T current = none;
+        while (true)
+        {
+            // Keep growing from the vertex that found the last path, if it is still in a tree
+            T v = current;
+            if (v != none)
+            {
+                nextActive[v] = none;
+                if (tree[v] == noTree)
+                    v = none;
+            }
+            if (v == none)
+            {
+                v = nextActiveVertex();
+                if (v == none)
+                    break;
+            }
+
+            T connectingArc = grow(v);
+            if (connectingArc == noArc)
+            {
+                current = none;
+                continue;
+            }
+
+            // Mark v active while it is out of the queue, so it is not added again
+            nextActive[v] = v;
+            current = v;
+
+            time++;
+            maxflow += augment(connectingArc);
+            adoptOrphans();
+        }
+
+        return maxflow;
+    }
+
+    // Residual capacities left by the last solve
+    const std::vector<U> &getResidualCapacities() const
+    {
+        return capacities;
+    }
+
+private:
+    enum Tree : unsigned char
+    {
+        noTree,
+        sourceTree,
+        sinkTree,
+    };
+
+    const G &graph;
+
+    // Residual capacities of the current solve
+    std::vector<U> capacities;
+
+    // Marks the end of the active queue and the absence of a vertex.
+    const T none;
+
+    // Parent arc values of the tree roots and of orphans.
+    T noArc{0};
+    T orphan{0};
+
+    std::vector<Tree> tree;
+
+    // Arc from a vertex to its parent. In the source tree flow goes along
+    // the anti-parallel arc, in the sink tree along the arc itself.
+    std::vector<T> parents;
+
+    // Active vertices are on the border of their tree and can grow it. They
+    // form an intrusive FIFO queue; the last vertex links to itself.
+    std::vector<T> nextActive;
+    T queueFirst{0};
+    T queueLast{0};
+
+    // Next arc to scan when growing from a vertex. Growth resumes here, so a
+    // terminal with many arcs is not rescanned after every augmentation.
+    std::vector<T> growArcs;
+
+    std::vector<T> orphans;
+
+    // A vertex with timestamp equal to time is known to be connected to its
+    // root, at the given distance.
+    std::vector<long long> timestamps;
+    std::vector<T> distances;
+    long long time{0};
+
+    void initializeTrees()
+    {
+        graph.copyCapacities(capacities);
+        noArc = graph.arcCount();
+        orphan = noArc + 1;
+
+        tree.assign(graph.V, noTree);
+        parents.assign(graph.V, noArc);
+        nextActive.assign(graph.V, none);
+        growArcs.resize(graph.V);
+        for (T v{0}; v < graph.V; ++v)
+            growArcs[v] = graph.firstArc(v);
+        timestamps.assign(graph.V, 0);
+        distances.assign(graph.V, 0);
+        queueFirst = none;
+        queueLast = none;
+        time = 0;
+
+        tree[graph.source] = sourceTree;
+        tree[graph.sink] = sinkTree;
+        setActive(graph.source);
+        setActive(graph.sink);
+    }
+
+    // Adds v to the queue. Its arcs are scanned from the start again, since
+    // a neighbour may have been freed.
+    void setActive(T v)
+    {
+        growArcs[v] = graph.firstArc(v);
+        if (nextActive[v] != none)
+            return;
+
+        if (queueLast != none)
+            nextActive[queueLast] = v;
+        else
+            queueFirst = v;
+        queueLast = v;
+        nextActive[v] = v;
+    }
+
+    // Removes vertices from the front of the queue until one in a tree is found.
+    T nextActiveVertex()
+    {
+        while (queueFirst != none)
+        {
+            T v = queueFirst;
+            queueFirst = nextActive[v] == v ? none : nextActive[v];
+            if (queueFirst == none)
+                queueLast = none;
+            nextActive[v] = none;
+
+            if (tree[v] != noTree)
+                return v;
+        }
+        return none;
+    }
+
+    // Residual capacity of arc e of v in the direction flow takes in v's tree.
+    U treeCapacity(T v, T e) const
+    {
+        return tree[v] == sourceTree ? capacities[e] : capacities[graph.reverse(e)];
+    }
+
+    // Grows the tree of v by its free neighbours. Returns an arc from the
+    // source tree to the sink tree if one is found, otherwise noArc.
+    T grow(T v)
+    {
+        for (T &e = growArcs[v]; e < graph.endArc(v); ++e)
+        {
+            if (treeCapacity(v, e) <= 0)
+                continue;
+
+            T w = graph.head(e);
+            if (tree[w] == noTree)
+            {
+                tree[w] = tree[v];
+                parents[w] = graph.reverse(e);
+                timestamps[w] = timestamps[v];
+                distances[w] = distances[v] + 1;
+                setActive(w);
+            }
+            else if (tree[w] != tree[v])
+            {
+                return tree[v] == sourceTree ? e : graph.reverse(e);
+            }
+            else if (timestamps[w] <= timestamps[v] && distances[w] > distances[v])
+            {
+                // Make w's path to the root shorter
+                parents[w] = graph.reverse(e);
+                timestamps[w] = timestamps[v];
+                distances[w] = distances[v] + 1;
+            }
+        }
+        return noArc;
+    }
+
+    // Pushes the bottleneck capacity along the path through the connecting
+    // arc. Vertices whose parent arc is saturated become orphans.
+    U augment(T connectingArc)
+    {
+        U bottleneck = capacities[connectingArc];
+
+        for (T v = graph.head(graph.reverse(connectingArc)); parents[v] != noArc; v = graph.head(parents[v]))
+        {
+            bottleneck = std::min(bottleneck, capacities[graph.reverse(parents[v])]);
+        }
+        for (T v = graph.head(connectingArc); parents[v] != noArc; v = graph.head(parents[v]))
+        {
+            bottleneck = std::min(bottleneck, capacities[parents[v]]);
+        }
+
+        capacities[connectingArc] -= bottleneck;
+        capacities[graph.reverse(connectingArc)] += bottleneck;
+
+        // Source tree: flow goes from the parent to the vertex
+        for (T v = graph.head(graph.reverse(connectingArc)); parents[v] != noArc;)
+        {
+            T e = parents[v];
+            capacities[graph.reverse(e)] -= bottleneck;
+            capacities[e] += bottleneck;
+            if (capacities[graph.reverse(e)] == 0)
+            {
+                parents[v] = orphan;
+                orphans.push_back(v);
+            }
+            v = graph.head(e);
+        }
+
+        // Sink tree: flow goes from the vertex to the parent
+        for (T v = graph.head(connectingArc); parents[v] != noArc;)
+        {
+            T e = parents[v];
+            capacities[e] -= bottleneck;
+            capacities[graph.reverse(e)] += bottleneck;
+            if (capacities[e] == 0)
+            {
+                parents[v] = orphan;
+                orphans.push_back(v);
+            }
+            v = graph.head(e);
+        }
+
+        return bottleneck;
+    }
+
+    void adoptOrphans()
+    {
+        for (std::size_t i{0}; i < orphans.size(); ++i)
+        {
+            adopt(orphans[i]);
+        }
+        orphans.clear();
+    }
+
+    // Returns the distance from v to its root, or none if the path to the
+    // root passes an orphan. Marks the vertices on a valid path.
+    T distanceToRoot(T v)
+    {
+        T distance{0};
+        T w = v;
+        while (true)
+        {
+            if (timestamps[w] == time)
+            {
+                distance += distances[w];
+                break;
+            }
+
+            T e = parents[w];
+            if (e == noArc)
+            {
+                timestamps[w] = time;
+                distances[w] = 0;
+                break;
+            }
+            if (e == orphan)
+                return none;
+
+            distance++;
+            w = graph.head(e);
+        }
+
+        T d = distance;
+        for (w = v; timestamps[w] != time; w = graph.head(parents[w]))
+        {
+            timestamps[w] = time;
+            distances[w] = d--;
+        }
+
+        return distance;
+    }
+
+    // Finds a new parent for v in its tree, preferring the one closest to the
+    // root. If there is none, v is freed and its children become orphans.
+    void adopt(T v)
+    {
+        T bestArc = noArc;
+        T bestDistance = none;
+
+        for (T e = graph.firstArc(v); e < graph.endArc(v); ++e)
+        {
+            T w = graph.head(e);
+            if (tree[w] != tree[v] || treeCapacity(w, graph.reverse(e)) <= 0)
+                continue;
+
+            T distance = distanceToRoot(w);
+            if (distance != none && distance < bestDistance)
+            {
+                bestArc = e;
+                bestDistance = distance;
+            }
+        }
+
+        if (bestArc != noArc)
+        {
+            parents[v] = bestArc;
+            timestamps[v] = time;
+            distances[v] = bestDistance + 1;
+            return;
+        }
+
+        for (T e = graph.firstArc(v); e < graph.endArc(v); ++e)
+        {
+            T w = graph.head(e);
+            if (tree[w] != tree[v])
+                continue;
+
+            // w may grow its tree into v again
+            if (treeCapacity(w, graph.reverse(e)) > 0)
+                setActive(w);
+
+            if (parents[w] != noArc && parents[w] != orphan && graph.head(parents[w]) == v)
+            {
+                parents[w] = orphan;
+                orphans.push_back(w);
+            }
+        }
+
+        tree[v] = noTree;
+    }
+};
+
+#endif // BOYKOV_KOLMOGOROV_H
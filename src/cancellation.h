@@ -0,0 +1,91 @@
+#ifndef CANCELLATION_H
+#define CANCELLATION_H
+
+#include <atomic>
+#include <chrono>
+
+// Stops a solve early: when cancel() is called, from any thread, or once
+// its time limit has passed. Solvers that support it check the token in
+// their outer loops, and return bounds on the max flow value when it has
+// expired.
+class CancellationToken
+{
+public:
+    CancellationToken() = default;
+
+    // Expires timeLimit after its construction. A deadline past the last
+    // time point of the clock is no limit.
+    explicit CancellationToken(std::chrono::steady_clock::duration timeLimit)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (timeLimit < std::chrono::steady_clock::time_point::max() - now)
+        {
+            deadline = now + timeLimit;
+            timed = true;
+        }
+    }
+
+    void cancel()
+    {
+        cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    // Returns true once cancelled or past the time limit. Reads the clock.
+    bool expired()
+    {
+        if (cancelled.load(std::memory_order_relaxed))
+            return true;
+        if (timed && std::chrono::steady_clock::now() >= deadline)
+        {
+            cancel();
+            return true;
+        }
+        return false;
+    }
+
+    // Like expired(), but only reads the clock on every pollInterval-th call,
+    // for loops whose iterations are short. Only one thread may poll a token.
+    bool poll()
+    {
+        if (++polls < pollInterval)
+            return cancelled.load(std::memory_order_relaxed);
+        polls = 0;
+        return expired();
+    }
+
+private:
+    static constexpr unsigned pollInterval = 256;
+
+    std::atomic<bool> cancelled{false};
+    std::chrono::steady_clock::time_point deadline{};
+    bool timed{false};
+    unsigned polls{0};
+};
+
+// Converts a time limit in seconds to a duration of the clock. Limits of
+// the longest duration the clock holds, about 292 years, or more are that
+// duration, which a CancellationToken treats as no limit.
+inline std::chrono::steady_clock::duration secondsToDuration(double seconds)
+{
+    const std::chrono::duration<double> limit(seconds);
+    if (limit >= std::chrono::steady_clock::duration::max())
+        return std::chrono::steady_clock::duration::max();
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(limit);
+}
+
+// Bounds on the max flow value from a solve that may have been stopped: the
+// value of the flow found, and the capacity of the best cut found. Both are
+// the max flow value if the solve finished.
+template <typename U>
+struct FlowBounds
+{
+    U lower;
+    U upper;
+
+    bool isExact() const
+    {
+        return lower == upper;
+    }
+};
+
+#endif // CANCELLATION_H
@@ -0,0 +1,136 @@
+#ifndef CAPACITY_SCALING_H
+#define CAPACITY_SCALING_H
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+#include "graph.h"
+
+// Augmenting path algorithm with capacity scaling. In the phase with scaling
+// parameter delta only residual arcs with capacity at least delta are used,
+// so every augmentation carries at least delta units of flow. Delta starts at
+// the largest power of two not above the largest capacity and is halved
+// after every phase. Paths are found by BFS, as in Edmonds-Karp.
+template <typename T, typename U>
+class CapacityScaling
+{
+public:
+    CapacityScaling(const Graph<T, U> &graph) : graph(graph) {}
+
+    U findMaxFlow()
+    {
+        U maxflow{0};
+        capacities.assign(graph.capacities.begin(), graph.capacities.end());
+
+        parentInfo.resize(graph.V);
+        visited.resize(graph.V);
+        queue.reserve(graph.V);
+
+        U maxCapacity{0};
+        if (!graph.capacities.empty())
+            maxCapacity = *std::max_element(graph.capacities.begin(), graph.capacities.end());
+
+        U delta{1};
+        while (delta <= maxCapacity / 2)
+            delta *= 2;
+
+        for (; delta >= 1; delta /= 2)
+        {
+            maxflow += augment(delta);
+        }
+
+        // Capacities below one are left after the last phase unless they are integral
+        if constexpr (!std::is_integral<U>::value)
+        {
+            maxflow += augment(std::numeric_limits<U>::denorm_min());
+        }
+
+        return maxflow;
+    }
+
+    // Residual capacities left by the last solve
+    const std::vector<U> &getResidualCapacities() const
+    {
+        return capacities;
+    }
+
+private:
+    const Graph<T, U> &graph;
+
+    // Residual capacities of the current solve
+    std::vector<U> capacities;
+
+    std::vector<ParentInfo<T, U>> parentInfo;
+    std::vector<bool> visited;
+    std::vector<T> queue;
+
+    // Augments along paths of arcs with capacity at least delta until there
+    // are none. Returns the amount of flow added.
+    U augment(const U delta)
+    {
+        U flow{0};
+
+        while (search(delta))
+        {
+            U pathflow = std::numeric_limits<U>::max();
+            T v = graph.sink;
+
+            // Find the maximum possible flow in the current path
+            while (v != graph.source)
+            {
+                pathflow = std::min(pathflow, capacities[parentInfo[v].edge]);
+                v = parentInfo[v].u;
+            }
+
+            // Update residual capacities of the edges and reverse edges
+            v = graph.sink;
+            while (v != graph.source)
+            {
+                T edge = parentInfo[v].edge;
+                capacities[edge] -= pathflow;
+                capacities[graph.antiParallel[edge]] += pathflow;
+                v = parentInfo[v].u;
+            }
+
+            flow += pathflow;
+        }
+
+        return flow;
+    }
+
+    // BFS from the source using only arcs with capacity at least delta.
+    // Returns true if the sink is reached.
+    bool search(const U delta)
+    {
+        std::fill(visited.begin(), visited.end(), false);
+        visited[graph.source] = true;
+
+        queue.clear();
+        queue.push_back(graph.source);
+
+        for (std::size_t i{0}; i < queue.size(); ++i)
+        {
+            T u = queue[i];
+
+            for (T e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e)
+            {
+                T v = graph.heads[e];
+                if (capacities[e] < delta or visited[v])
+                    continue;
+
+                parentInfo[v].u = u;
+                parentInfo[v].edge = e;
+                if (v == graph.sink)
+                    return true;
+
+                queue.push_back(v);
+                visited[v] = true;
+            }
+        }
+
+        return false;
+    }
+};
+
+#endif // CAPACITY_SCALING_H
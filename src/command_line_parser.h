@@ -3,7 +3,10 @@
 
 #include <string>
 #include <string_view>
+#include <vector>
 #include <cstring>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <stdexcept>
 #include <types.h>
@@ -27,29 +30,158 @@ public:
             }
         }
 
-        if (argc < 3)
+        std::vector<std::string> positional;
+
+        for (int i{1}; i < argc; ++i)
         {
-            throw std::invalid_argument("Algorithm and path must be specified");
+            std::string_view arg{argv[i]};
+
+            if (arg == "-t" || arg == "--threads")
+            {
+                if (++i == argc)
+                {
+                    throw std::invalid_argument(std::string(arg) + " requires a value");
+                }
+                m_options.threadCount = parseThreadCount(argv[i]);
+            }
+            else if (arg == "--value-only")
+            {
+                m_options.valueOnly = true;
+            }
+            else if (arg.substr(0, 8) == "--stats=")
+            {
+                if (arg.substr(8) != "json")
+                {
+                    throw std::invalid_argument("Unknown statistics format " + std::string(arg.substr(8)));
+                }
+                m_options.printStats = true;
+            }
+            else if (arg.substr(0, 10) == "--threads=")
+            {
+                m_options.threadCount = parseThreadCount(std::string(arg.substr(10)));
+            }
+            else if (arg == "--lambdas")
+            {
+                if (++i == argc)
+                {
+                    throw std::invalid_argument(std::string(arg) + " requires a value");
+                }
+                m_options.lambdas = parseLambdas(argv[i]);
+            }
+            else if (arg.substr(0, 10) == "--lambdas=")
+            {
+                m_options.lambdas = parseLambdas(std::string(arg.substr(10)));
+            }
+            else if (arg == "--reduce")
+            {
+                m_options.reduce = true;
+            }
+            else if (arg == "--verify")
+            {
+                m_verify = true;
+            }
+            else if (arg == "--time-limit")
+            {
+                if (++i == argc)
+                {
+                    throw std::invalid_argument(std::string(arg) + " requires a value");
+                }
+                m_options.timeLimit = parseTimeLimit(argv[i]);
+            }
+            else if (arg.substr(0, 13) == "--time-limit=")
+            {
+                m_options.timeLimit = parseTimeLimit(std::string(arg.substr(13)));
+            }
+            else if (arg.substr(0, 10) == "--reorder=")
+            {
+                m_options.vertexOrder = stringToVertexOrder(std::string(arg.substr(10)));
+            }
+            else if (arg.size() > 1 && arg[0] == '-')
+            {
+                throw std::invalid_argument("Unknown option " + std::string(arg));
+            }
+            else
+            {
+                positional.emplace_back(arg);
+            }
         }
 
-        m_algorithm = AlgorithmEnums::stringToEnum(argv[1]);
+        if (!positional.empty() && positional[0] == "convert")
+        {
+            if (positional.size() != 3)
+            {
+                throw std::invalid_argument("convert requires an input and an output path");
+            }
+            m_convert = true;
+            m_filePath = positional[1];
+            m_outputPath = positional[2];
+            return;
+        }
 
-        m_filePath = argv[2];
+        if (positional.size() < 2)
+        {
+            throw std::invalid_argument("Algorithm and path must be specified");
+        }
 
-        if (argc > 3)
+        if (positional.size() > 2)
         {
             throw std::invalid_argument("Too many arguments");
         }
+
+        m_algorithm = AlgorithmEnums::stringToEnum(positional[0]);
+        if (m_options.valueOnly && m_algorithm != AlgorithmEnums::Algorithm::hipr)
+        {
+            throw std::invalid_argument("--value-only is only supported by hipr");
+        }
+        if (!m_options.lambdas.empty() && m_algorithm != AlgorithmEnums::Algorithm::pr)
+        {
+            throw std::invalid_argument("--lambdas is only supported by pr");
+        }
+        if (!m_options.lambdas.empty() && m_options.reduce)
+        {
+            throw std::invalid_argument("--reduce can not be used with --lambdas, which change the terminal capacities");
+        }
+        if (m_options.timeLimit > 0 && (!AlgorithmEnums::isStoppable(m_algorithm) || !m_options.lambdas.empty()))
+        {
+            throw std::invalid_argument("--time-limit is only supported by ek, dinic, pr, hipr, unit and auto, without --lambdas");
+        }
+
+        m_filePath = positional[1];
     }
 
-    void printUsage(std::string_view program)
+    void printUsage(std::string_view program) const
     {
-        std::cerr << "usage: " << program << " <algorithm> <path>\n\n"
-                  << "<algorithm>: Choose one of the following [ek, dinic, pr]\n"
+        std::cerr << "usage: " << program << " [options] <algorithm> <path>\n"
+                  << "       " << program << " [options] convert <path> <output>\n\n"
+                  << "<algorithm>: Choose one of the following [ek, dinic, pr, prpar, hipr, scaling, bk, hpf, unit, auto]\n"
                   << "ek:\tEdmond-Karps algorithm with BFS\n"
                   << "dinic:\tDinic's algorithm\n"
                   << "pr:\tGoldberg & Tarjans push-relabel algorithm with relabel-to-front and gap heuristic\n"
-                  << "<path>: Must be a file path to a max flow problem in DIMACS format\n\n"
+                  << "prpar:\tMulti-threaded synchronous push-relabel algorithm with global relabeling\n"
+                  << "hipr:\tHighest-label push-relabel algorithm with global relabeling and gap heuristic\n"
+                  << "scaling:\tAugmenting paths with capacity scaling\n"
+                  << "bk:\tBoykov-Kolmogorov algorithm with reused search trees, suited for grid graphs\n"
+                  << "hpf:\tHochbaum's pseudoflow algorithm, highest label variant\n"
+                  << "unit:\tDinic's algorithm with bit-packed residual arcs, for graphs with capacities of 0 or 1 only\n"
+                  << "auto:\tunit on graphs with capacities of 0 or 1, dinic on others; the one that ran is printed\n"
+                  << "<path>: Must be a file path to a max flow problem in DIMACS format, in binary format, or a grid problem\n"
+                  << "convert:\tConvert the DIMACS file <path> to the binary format, written to <output>\n\n"
+                  << "-t,--threads <n>\tNumber of threads used by prpar, by the BFS of ek, dinic and hipr, and for reading the file\n"
+                  << "\t\t\t(default: one per hardware thread for prpar and reading, one for the BFS)\n"
+                  << "--value-only\t\tStop hipr once the max flow value is known, without building the flow, and print the value\n"
+                  << "\t\t\tand the source side of a minimum cut\n"
+                  << "--stats=json\t\tPrint the times of reading, building and solving as JSON, and the counters of ek, dinic and pr\n"
+                  << "\t\t\tif built with MAXFLOW_STATS\n"
+                  << "--lambdas <list>\tSolve the parametric problem with pr at every value in the comma separated list, where\n"
+                  << "\t\t\tlambda is added to the capacities of source arcs and subtracted from those of sink arcs\n"
+                  << "--reorder=<order>\tRenumber the vertices before solving, for locality of the searches: bfs (from the\n"
+                  << "\t\t\tsource), rcm (reverse Cuthill-McKee), degree (decreasing degree) or none (default)\n"
+                  << "--time-limit <s>\tStop ek, dinic, pr, hipr, unit or auto after <s> seconds of solving, and print the flow found\n"
+                  << "\t\t\tas a lower bound and the capacity of the best cut found as an upper bound on the max flow value\n"
+                  << "--verify\t\tRead a binary graph file in full and check its checksum and arc arrays before solving;\n"
+                  << "\t\t\twithout it, the file is trusted and only the pages the solver reads are loaded\n"
+                  << "--reduce\t\tCancel the source and sink capacity of vertices, remove vertices on no path from the source\n"
+                  << "\t\t\tto the sink and contract chains of vertices with two neighbours before solving\n"
                   << "-h,--help\t\tShow this help message"
                   << std::endl;
     }
@@ -64,9 +196,102 @@ public:
         return m_filePath;
     }
 
+    SolverOptions getOptions() const
+    {
+        return m_options;
+    }
+
+    // True for the convert command, which writes a binary graph instead of solving
+    bool isConvert() const
+    {
+        return m_convert;
+    }
+
+    std::string getOutputPath() const
+    {
+        return m_outputPath;
+    }
+
+    // True if a binary graph file is checked in full before it is solved
+    bool isVerify() const
+    {
+        return m_verify;
+    }
+
 private:
     AlgorithmEnums::Algorithm m_algorithm{};
     std::string m_filePath{};
+    std::string m_outputPath{};
+    bool m_convert{false};
+    bool m_verify{false};
+    SolverOptions m_options{};
+
+    static unsigned parseThreadCount(const std::string &value)
+    {
+        std::size_t parsed{0};
+        int threadCount{0};
+        try
+        {
+            threadCount = std::stoi(value, &parsed);
+        }
+        catch (const std::exception &)
+        {
+            parsed = 0;
+        }
+
+        if (parsed != value.size() || threadCount < 1)
+        {
+            throw std::invalid_argument("Thread count must be a positive integer, got " + value);
+        }
+        return threadCount;
+    }
+
+    static double parseTimeLimit(const std::string &value)
+    {
+        std::size_t parsed{0};
+        double seconds{0};
+        try
+        {
+            seconds = std::stod(value, &parsed);
+        }
+        catch (const std::exception &)
+        {
+            parsed = 0;
+        }
+
+        if (parsed == 0 || parsed != value.size() || !(seconds > 0) || !std::isfinite(seconds))
+        {
+            throw std::invalid_argument("Time limit must be a positive, finite number of seconds, got " + value);
+        }
+        return seconds;
+    }
+
+    static std::vector<double> parseLambdas(const std::string &list)
+    {
+        std::vector<double> lambdas;
+        std::size_t begin{0};
+        while (begin <= list.size())
+        {
+            std::size_t end = std::min(list.find(',', begin), list.size());
+            std::string value = list.substr(begin, end - begin);
+            std::size_t parsed{0};
+            try
+            {
+                lambdas.push_back(std::stod(value, &parsed));
+            }
+            catch (const std::exception &)
+            {
+                parsed = 0;
+            }
+
+            if (parsed == 0 || parsed != value.size())
+            {
+                throw std::invalid_argument("Lambda values must be numbers, got " + value);
+            }
+            begin = end + 1;
+        }
+        return lambdas;
+    }
 };
 
 #endif
\ No newline at end of file
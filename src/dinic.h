@@ -2,159 +2,179 @@
 #define DINIC_H
 
 #include <vector>
-#include <queue>
-#include <stack>
-#include <limits.h>
 #include <limits>
-#include <string>
-#include <iostream>
-#include <stdexcept>
-#include <functional> // for std::function
+#include <algorithm>
 #include "graph.h"
-#include <memory>
-#include <cassert>
+#include "bfs.h"
+#include "stats.h"
+#include "min_cut.h"
+#include "cancellation.h"
 
-template <typename T, typename U>
+// Runs on a Graph, or on a GridGraph given as G
+template <typename T, typename U, typename G = Graph<T, U>>
 class Dinic
 {
 public:
-    Dinic(Graph<T, U> &graph) : graph(graph) {}
+    Dinic(const G &graph, unsigned threadCount = 1) : graph(graph), unreached(graph.V), bfs(threadCount) {}
 
     U findMaxFlow()
     {
         U maxflow{0};
-        std::vector<std::vector<std::shared_ptr<Edge<T, U>>>> levelGraph(graph.V);
+        graph.copyCapacities(capacities);
+        stopped = false;
 
-        // Initialize parent information vector
-        std::vector<ParentInfo<T, U>> parentInfo(graph.V);
-
-        while (findLevelGraph(levelGraph))
+        // Every phase finds a blocking flow in the level graph
+        while (!isCancelled() && findLevelGraph())
         {
-            // As long as there are augmenting paths from source to sink in the level-graph
-            while (findAugmentingPath(levelGraph, parentInfo))
-            {
-                U pathflow = std::numeric_limits<U>::max();
-                T v = graph.sink;
-                T u;
+            ++stats.phases;
+            currents.resize(graph.V);
+            for (T u{0}; u < graph.V; ++u)
+                currents[u] = graph.firstArc(u);
+            maxflow += findBlockingFlow();
+        }
 
-                // Find the maximum possible flow in the current path
-                while (v != graph.source)
-                {
-                    u = parentInfo[v].u;
-                    std::shared_ptr<Edge<T, U>> e = parentInfo[v].edge;
-                    pathflow = std::min(pathflow, e->capacity);
-                    v = u;
-                }
+        return maxflow;
+    }
 
-                // Update residual capacities of the edges and reverse edges
-                v = graph.sink;
-                while (v != graph.source)
-                {
-                    u = parentInfo[v].u;
-                    std::shared_ptr<Edge<T, U>> edge = parentInfo[v].edge;
-                    edge->capacity -= pathflow;
-
-                    // Convert the weak_ptr to a shared_ptr before accessing
-                    std::shared_ptr<Edge<T, U>> antiParallelEdge = edge->antiParallel.lock();
-                    assert(antiParallelEdge && "Failed to lock antiParallel weak_ptr");
-                    antiParallelEdge->capacity += pathflow;
-                    v = u;
-                }
+    // Solves as findMaxFlow() until the token expires. The upper bound is
+    // the best cut between the BFS levels of the residual graph left.
+    FlowBounds<U> findFlowBounds(CancellationToken &token)
+    {
+        cancellation = &token;
+        U flow = findMaxFlow();
+        cancellation = nullptr;
+        if (!stopped)
+            return {flow, flow};
+
+        findLevelGraph();
+        return {flow, findBestThresholdCut<U>(graph, levels, graph.V + 1)};
+    }
 
-                // Add path flow to the maximum flow
-                maxflow += pathflow;
-            }
-            levelGraph.clear();
-            levelGraph.resize(graph.V);
-        }
+    const Stats &getStats() const
+    {
+        return stats;
+    }
 
-        return maxflow;
+    // Residual capacities left by the last solve
+    const std::vector<U> &getResidualCapacities() const
+    {
+        return capacities;
     }
 
 private:
-    Graph<T, U> &graph;
+    const G &graph;
 
-    bool findLevelGraph(std::vector<std::vector<std::shared_ptr<Edge<T, U>>>> &levelGraph)
-    {
-        bool sinkFound = false;
-        std::vector<T> levels(graph.V, graph.V);
-        T currentLevel{0};
+    // Residual capacities of the current solve
+    std::vector<U> capacities;
+    Stats stats;
 
-        std::queue<T> q;
-        q.push(graph.source);
-        levels[graph.source] = currentLevel;
+    // Level of vertices not in the level graph.
+    const T unreached;
 
-        while (!q.empty())
-        {
-            currentLevel++;
-            int k = q.size();
-            while (k)
-            {
-                T u = q.front();
-                q.pop();
-                k--;
+    // BFS level of every vertex. The level graph consists of the residual
+    // arcs going from one level to the next.
+    std::vector<T> levels;
 
-                for (std::shared_ptr<Edge<T, U>> edgePtr : graph.adj_list[u])
-                {
-                    if (levels[edgePtr->v] >= currentLevel && edgePtr->capacity > 0)
-                    {
-                        if (edgePtr->v == graph.sink)
-                        {
-                            sinkFound = true;
-                        }
-
-                        else if (levels[edgePtr->v] > currentLevel)
-                        {
-                            q.push(edgePtr->v);
-                        }
-
-                        levels[edgePtr->v] = currentLevel;
-                        levelGraph[u].push_back(edgePtr);
-                    }
-                }
-            }
-        }
+    // Current arc of every vertex. Arcs before it are saturated or lead to
+    // dead ends, so they are never scanned again in the same phase.
+    std::vector<T> currents;
+
+    FrontierBFS<T> bfs;
+    std::vector<T> path;
+
+    // Token checked once per phase and per augmenting path, if set
+    CancellationToken *cancellation{nullptr};
+    bool stopped{false};
 
-        return sinkFound;
+    bool isCancelled()
+    {
+        stopped = stopped || (cancellation && cancellation->expired());
+        return stopped;
     }
 
-    bool findAugmentingPath(std::vector<std::vector<std::shared_ptr<Edge<T, U>>>> &levelGraph, std::vector<ParentInfo<T, U>> &parentInfo)
+    // Computes the levels by BFS from the source. Returns true if the sink is
+    // reached. Vertices at the sink's level or beyond can not lead to the
+    // sink, so the BFS stops at its level.
+    bool findLevelGraph()
     {
-        std::stack<T> s;
-        std::vector<bool> visited(graph.V, false);
+        auto open = [this](T e)
+        {
+            return capacities[e] > 0;
+        };
+        bfs.search(graph, graph.source, open, levels, nullptr, graph.sink);
+        stats.arcsScanned += bfs.getArcsScanned();
+        return levels[graph.sink] != unreached;
+    }
 
-        // Push source to the stack and mark it as visited
-        s.push(graph.source);
-        visited[graph.source] = true;
+    // Finds a blocking flow in the level graph with a single DFS. The path
+    // from the source is kept as a stack of arcs. After an augmentation the
+    // DFS continues from the tail of the first saturated arc, and dead ends
+    // are removed from the level graph.
+    U findBlockingFlow()
+    {
+        U flow{0};
+        path.clear();
+        T u = graph.source;
 
-        // While there are still vertices to process
-        while (!s.empty())
+        while (true)
         {
-            T u = s.top();
-            s.pop();
-
-            // If we've reached the sink, return true
             if (u == graph.sink)
-                return true;
+            {
+                U pathflow = std::numeric_limits<U>::max();
+                for (T e : path)
+                {
+                    pathflow = std::min(pathflow, capacities[e]);
+                }
 
-            // For every adjacent edge
-            for (std::shared_ptr<Edge<T, U>> e : levelGraph[u])
+                for (T e : path)
+                {
+                    capacities[e] -= pathflow;
+                    capacities[graph.reverse(e)] += pathflow;
+                }
+                flow += pathflow;
+                ++stats.augmentingPaths;
+                if (cancellation && cancellation->poll())
+                {
+                    stopped = true;
+                    break;
+                }
+
+                // Retreat to the tail of the first saturated arc
+                std::size_t k{0};
+                while (capacities[path[k]] > 0)
+                    k++;
+                path.resize(k);
+                u = k == 0 ? graph.source : graph.head(path[k - 1]);
+                continue;
+            }
+
+            // Advance along the current arc, if it is in the level graph
+            T &e = currents[u];
+            const T end = graph.endArc(u);
+            const T first = e;
+            while (e < end && (capacities[e] == 0 || levels[graph.head(e)] != levels[u] + 1))
+                e++;
+            stats.arcsScanned += e - first + (e < end);
+
+            if (e < end)
             {
-                // If not positive capacity or we've already visited the vertex, skip it
-                if (e->capacity == 0 or visited[e->v])
-                    continue;
-
-                // Otherwise, update parent info, push node to the data structure
-                parentInfo[e->v].u = u;
-                parentInfo[e->v].edge = e;
-                s.push(e->v);
-                visited[e->v] = true;
+                path.push_back(e);
+                u = graph.head(e);
+            }
+            else
+            {
+                // u is a dead end
+                if (u == graph.source)
+                    break;
+
+                levels[u] = unreached;
+                path.pop_back();
+                u = path.empty() ? graph.source : graph.head(path.back());
             }
         }
 
-        // If we haven't found a path to the sink, return false
-        return false;
+        return flow;
     }
 };
 
-#endif // DINIC_H
\ No newline at end of file
+#endif // DINIC_H
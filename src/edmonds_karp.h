@@ -2,14 +2,16 @@
 #define EK_H
 
 #include <vector>
-#include <queue>
-#include <stack>
 #include <limits>
 #include <string>
 #include <iostream>
 #include <stdexcept>
 #include <functional>
 #include "graph.h"
+#include "bfs.h"
+#include "stats.h"
+#include "min_cut.h"
+#include "cancellation.h"
 #include <cassert>
 
 template <typename T, typename U>
@@ -17,46 +19,37 @@ class EdmondsKarp
 {
 
 public:
-    EdmondsKarp(Graph<T, U> &graph) : graph(graph) {}
+    EdmondsKarp(const Graph<T, U> &graph, unsigned threadCount = 1) : graph(graph), bfs(threadCount) {}
 
     U findMaxFlow()
     {
         U maxflow = 0;
-
-        // Initialize parent information vector
-        std::vector<ParentInfo<T, U>> parentInfo(graph.V);
+        capacities.assign(graph.capacities.begin(), graph.capacities.end());
+        stopped = false;
 
         // As long as there are augmenting paths from source to sink
-        while (search(parentInfo))
+        while (!isCancelled() && search())
         {
+            ++stats.augmentingPaths;
             U pathflow = std::numeric_limits<U>::max();
             T v = graph.sink;
-            T u;
 
             // Find the maximum possible flow in the current path
             while (v != graph.source)
             {
-                u = parentInfo[v].u;
-                std::shared_ptr<Edge<T, U>> e = parentInfo[v].edge;
-                pathflow = std::min(pathflow, e->capacity);
-                v = u;
+                T edge = parents[v];
+                pathflow = std::min(pathflow, capacities[edge]);
+                v = graph.heads[graph.antiParallel[edge]];
             }
 
             // Update residual capacities of the edges and reverse edges
             v = graph.sink;
             while (v != graph.source)
             {
-                u = parentInfo[v].u;
-                std::shared_ptr<Edge<T, U>> edge = parentInfo[v].edge;
-                edge->capacity -= pathflow;
-
-                // Convert the weak_ptr to a shared_ptr before accessing
-                std::shared_ptr<Edge<T, U>> antiParallelEdge = edge->antiParallel.lock();
-                assert(antiParallelEdge && "Failed to lock antiParallel weak_ptr");
-
-                antiParallelEdge->capacity += pathflow;
-
-                v = u;
+                T edge = parents[v];
+                capacities[edge] -= pathflow;
+                capacities[graph.antiParallel[edge]] += pathflow;
+                v = graph.heads[graph.antiParallel[edge]];
             }
             // Add path flow to the maximum flow
             maxflow += pathflow;
@@ -66,45 +59,65 @@ public:
         return maxflow;
     }
 
-private:
-    Graph<T, U> &graph;
+    // Solves as findMaxFlow() until the token expires. The upper bound is
+    // the best cut between the BFS levels of the residual graph left.
+    FlowBounds<U> findFlowBounds(CancellationToken &token)
+    {
+        cancellation = &token;
+        U flow = findMaxFlow();
+        cancellation = nullptr;
+        if (!stopped)
+            return {flow, flow};
+
+        search();
+        return {flow, findBestThresholdCut<U>(graph, distances, graph.V + 1)};
+    }
 
-    bool search(std::vector<ParentInfo<T, U>> &parentInfo)
+    const Stats &getStats() const
     {
-        std::queue<T> q;
+        return stats;
+    }
 
-        // Push source to the data structure and mark it as visited
-        q.push(graph.source);
-        std::vector<bool> visited(graph.V, false);
-        visited[graph.source] = true;
+    // Residual capacities left by the last solve
+    const std::vector<U> &getResidualCapacities() const
+    {
+        return capacities;
+    }
 
-        // While there are still nodes to process
-        while (!q.empty())
-        {
-            T u = q.front();
-            q.pop();
+private:
+    const Graph<T, U> &graph;
 
-            // If we've reached the sink, return true
-            if (u == graph.sink)
-                return true;
+    // Residual capacities of the current solve
+    std::vector<U> capacities;
+    Stats stats;
 
-            // For every adjacent edge
-            for (std::shared_ptr<Edge<T, U>> e : graph.adj_list[u])
-            {
-                // If not full capacity or we've already visited the node, skip it
-                if (e->capacity == 0 or visited[e->v])
-                    continue;
-
-                // Otherwise, update parent info, push node to the data structure
-                parentInfo[e->v].u = u;
-                parentInfo[e->v].edge = e;
-                q.push(e->v);
-                visited[e->v] = true;
-            }
-        }
+    FrontierBFS<T> bfs;
+
+    // BFS distances from the source, and the arc into every reached vertex
+    std::vector<T> distances;
+    std::vector<T> parents;
+
+    // Token checked before every search, if set
+    CancellationToken *cancellation{nullptr};
+    bool stopped{false};
 
-        // If we haven't found a path to the sink, return false
-        return false;
+    bool isCancelled()
+    {
+        stopped = stopped || (cancellation && cancellation->expired());
+        return stopped;
+    }
+
+    // Finds a shortest augmenting path by BFS from the source. Returns true
+    // if the sink is reached.
+    bool search()
+    {
+        auto open = [this](T e)
+        {
+            return capacities[e] > 0;
+        };
+        bfs.search(graph, graph.source, open, distances, &parents, graph.sink);
+        stats.arcsScanned += bfs.getArcsScanned();
+        return distances[graph.sink] != graph.V;
     }
 };
 
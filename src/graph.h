@@ -2,53 +2,174 @@
 #define GRAPH_H
 
 #include <vector>
+#include <stdexcept>
+#include <algorithm>
 #include <memory>
+#include <utility>
+#include <cstddef>
 
+// An input arc u->v. The capacity of later arcs v->u is added to
+// antiParallelCapacity, so an arc and its anti-parallel arcs share one arc pair.
 template <typename T, typename U>
 struct Edge
 {
+    T u;
     T v;
     U capacity;
-    std::weak_ptr<Edge<T, U>> antiParallel;
+    U antiParallelCapacity;
 
-    Edge(T v, U capacity) : v(v), capacity(capacity) {}
+    Edge() = default;
+    Edge(T u, T v, U capacity) : u(u), v(v), capacity(capacity), antiParallelCapacity(0) {}
 };
 
 template <typename T, typename U>
 struct ParentInfo
 {
     T u;
-    std::shared_ptr<Edge<T, U>> edge;
+    T edge;
+};
+
+// Contiguous array of a graph. It either owns its elements, or views memory
+// owned by someone else, such as a mapped file. Copies always own.
+template <typename X>
+class GraphArray
+{
+public:
+    using value_type = X;
+    using iterator = X *;
+    using const_iterator = const X *;
+
+    GraphArray() = default;
+    GraphArray(const GraphArray &other) : storage(other.begin(), other.end()) { own(); }
+    GraphArray(GraphArray &&other) noexcept : storage(std::move(other.storage)), first(other.first), count(other.count)
+    {
+        other.first = nullptr;
+        other.count = 0;
+    }
+
+    GraphArray &operator=(GraphArray other) noexcept
+    {
+        storage.swap(other.storage);
+        std::swap(first, other.first);
+        std::swap(count, other.count);
+        return *this;
+    }
+
+    GraphArray &operator=(std::vector<X> &&elements)
+    {
+        storage = std::move(elements);
+        own();
+        return *this;
+    }
+
+    void resize(std::size_t size)
+    {
+        storage.resize(size);
+        own();
+    }
+
+    // Views size elements at data, without copying them
+    void view(X *data, std::size_t size)
+    {
+        storage = {};
+        first = data;
+        count = size;
+    }
+
+    X &operator[](std::size_t i) { return first[i]; }
+    const X &operator[](std::size_t i) const { return first[i]; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    X *data() { return first; }
+    const X *data() const { return first; }
+    X *begin() { return first; }
+    X *end() { return first + count; }
+    const X *begin() const { return first; }
+    const X *end() const { return first + count; }
+
+    bool operator==(const GraphArray &other) const
+    {
+        return std::equal(begin(), end(), other.begin(), other.end());
+    }
+
+private:
+    std::vector<X> storage;
+    X *first{nullptr};
+    std::size_t count{0};
+
+    void own()
+    {
+        first = storage.data();
+        count = storage.size();
+    }
 };
 
+// Graph in compressed sparse row format.
+// The arcs leaving vertex u are the arc indices [offsets[u], offsets[u + 1]).
+// Arc a points to heads[a], has capacity capacities[a], and its
+// anti-parallel arc is antiParallel[a].
+// Solvers do not change the graph. Each solver keeps the residual capacities
+// in its own array, copied from capacities when a solve starts, so a graph can
+// be solved many times, and by several solvers at once.
 template <typename T, typename U>
 class Graph
 {
 public:
-    std::vector<std::vector<std::shared_ptr<Edge<T, U>>>> adj_list;
+    GraphArray<T> offsets;
+    GraphArray<T> heads;
+    GraphArray<U> capacities;
+    GraphArray<T> antiParallel;
     const T V;
-    const int E;
+    const long long E;
     const T source;
     const T sink;
 
-    Graph(int V, int E, int source, int sink) : adj_list(V), V(V), E(E), source(source), sink(sink) {}
+    Graph(T V, long long E, T source, T sink) : V(V), E(E), source(source), sink(sink) {}
 
-    void addEdge(const T u, const T v, const U cap)
+    // Returns the arc u->v, or the number of arcs if there is none
+    T findArc(T u, T v) const
     {
-        // Create edge.
-        auto edge = std::make_shared<Edge<T, U>>(v, cap);
+        for (T e = offsets[u]; e < offsets[u + 1]; ++e)
+        {
+            if (heads[e] == v)
+                return e;
+        }
+        return heads.size();
+    }
+
+    // Arc interface shared with GridGraph, for solvers that run on both
+    T arcCount() const { return heads.size(); }
+    T firstArc(T u) const { return offsets[u]; }
+    T endArc(T u) const { return offsets[u + 1]; }
+    T head(T e) const { return heads[e]; }
+    T reverse(T e) const { return antiParallel[e]; }
+    U capacity(T e) const { return capacities[e]; }
 
-        // Create corresponding anti-parallel edge.
-        auto antiParallelEdge = std::make_shared<Edge<T, U>>(u, 0);
+    void copyCapacities(std::vector<U> &residual) const
+    {
+        residual.assign(capacities.begin(), capacities.end());
+    }
 
-        // Assign anti-parallel edges.
-        edge->antiParallel = antiParallelEdge;
-        antiParallelEdge->antiParallel = edge;
+    // Uses arc arrays laid out by a GraphBuilder or stored in a mapped file.
+    // The arrays are not copied; storage keeps their memory alive as long as
+    // the graph.
+    void attach(T *offsetData, T *headData, U *capacityData, T *antiParallelData,
+                std::size_t arcCount, std::shared_ptr<void> storage)
+    {
+        if (!offsets.empty())
+        {
+            throw std::logic_error("Arcs can only be attached to an empty graph.");
+        }
 
-        // Add edge pointers to adjacency list.
-        adj_list[u].push_back(edge);
-        adj_list[v].push_back(antiParallelEdge);
+        offsets.view(offsetData, V + 1);
+        heads.view(headData, arcCount);
+        capacities.view(capacityData, arcCount);
+        antiParallel.view(antiParallelData, arcCount);
+        attached = std::move(storage);
     }
+
+private:
+    std::shared_ptr<void> attached;
 };
 
 #endif
@@ -0,0 +1,241 @@
+#ifndef GRAPH_BUILDER_H
+#define GRAPH_BUILDER_H
+
+#include <vector>
+#include <memory>
+#include <new>
+#include <algorithm>
+#include <stdexcept>
+#include <cstddef>
+#include <utility>
+#include "graph.h"
+#include "parallel.h"
+
+// Collects the arcs of a graph as (u, v, capacity) triples and lays them out
+// in CSR format.
+//
+// The arcs are counting sorted on their smaller endpoint, then the arcs of
+// each vertex on their larger endpoint, so all arcs between two vertices end
+// up next to each other. The first arc u->v between two vertices creates an
+// arc pair, and later arcs v->u add to the capacity of its anti-parallel arc.
+// A later arc u->v is a parallel arc, which is not allowed. The arc arrays of
+// the graph are then filled in one allocation. Sorting, pairing and filling
+// run on threadCount threads; pairing needs memory for the arcs of one vertex
+// per thread.
+template <typename T, typename U>
+class GraphBuilder
+{
+public:
+    GraphBuilder(T V, T source, T sink) : V(V), source(source), sink(sink) {}
+
+    void reserve(std::size_t arcCount)
+    {
+        arcs.reserve(arcCount);
+    }
+
+    void addArc(const T u, const T v, const U cap)
+    {
+        checkNotPaired();
+        arcs.emplace_back(u, v, cap);
+    }
+
+    // Adds the arcs after the ones already added
+    void addArcs(std::vector<Edge<T, U>> &&more)
+    {
+        checkNotPaired();
+        if (arcs.empty())
+            arcs = std::move(more);
+        else
+            arcs.insert(arcs.end(), more.begin(), more.end());
+    }
+
+    std::size_t arcCount() const
+    {
+        return arcs.size();
+    }
+
+    // Returns the earliest added arc that is parallel to an arc added before
+    // it, or arcCount() if there is none.
+    std::size_t findParallelArc(unsigned threadCount = 1)
+    {
+        pairArcs(threadCount);
+        return parallelArc;
+    }
+
+    // Returns the graph of the added arcs. The builder is empty afterwards.
+    Graph<T, U> build(unsigned threadCount = 1)
+    {
+        threadCount = std::max(1u, threadCount);
+        if (findParallelArc(threadCount) < arcs.size())
+        {
+            throw std::logic_error("Parallel edges not allowed.");
+        }
+
+        // Slot 2k is arc k and slot 2k + 1 its anti-parallel arc. Arcs merged
+        // into an earlier arc get the key V, which sorts them after the arcs
+        // of the last vertex, where they are not used.
+        const std::size_t slotCount = 2 * arcs.size();
+        std::vector<T> positions(slotCount);
+        auto tail = [this](std::size_t slot)
+        {
+            std::size_t k = slot / 2;
+            if (owners[k] != static_cast<T>(k))
+                return V;
+            return slot % 2 == 0 ? arcs[k].u : arcs[k].v;
+        };
+        auto place = [&positions](std::size_t slot, T position)
+        {
+            positions[slot] = position;
+        };
+        std::vector<T> offsets = countingSort<T>(slotCount, V + 1, tail, place, threadCount);
+        const std::size_t graphArcCount = offsets[V];
+
+        // Offsets, heads, anti-parallel arcs and capacities share one block
+        auto padded = [](std::size_t bytes)
+        {
+            const std::size_t alignment = alignof(std::max_align_t);
+            return (bytes + alignment - 1) / alignment * alignment;
+        };
+        const std::size_t offsetBytes = padded((V + 1) * sizeof(T));
+        const std::size_t indexBytes = padded(graphArcCount * sizeof(T));
+        const std::size_t capacityBytes = padded(graphArcCount * sizeof(U));
+        std::shared_ptr<void> storage(::operator new(offsetBytes + 2 * indexBytes + capacityBytes),
+                                      [](void *block)
+                                      { ::operator delete(block); });
+
+        char *block = static_cast<char *>(storage.get());
+        T *offsetData = reinterpret_cast<T *>(block);
+        T *heads = reinterpret_cast<T *>(block + offsetBytes);
+        T *antiParallel = reinterpret_cast<T *>(block + offsetBytes + indexBytes);
+        U *capacities = reinterpret_cast<U *>(block + offsetBytes + 2 * indexBytes);
+        std::copy(offsets.begin(), offsets.begin() + V + 1, offsetData);
+
+        auto fill = [&](unsigned id)
+        {
+            std::size_t end = partitionBegin(arcs.size(), id + 1, threadCount);
+            for (std::size_t k = partitionBegin(arcs.size(), id, threadCount); k < end; ++k)
+            {
+                if (owners[k] != static_cast<T>(k))
+                    continue;
+
+                const auto &arc = arcs[k];
+                T a = positions[2 * k];
+                T b = positions[2 * k + 1];
+
+                heads[a] = arc.v;
+                capacities[a] = arc.capacity;
+                antiParallel[a] = b;
+
+                heads[b] = arc.u;
+                capacities[b] = arc.antiParallelCapacity;
+                antiParallel[b] = a;
+            }
+        };
+        runInParallel(threadCount, fill);
+
+        Graph<T, U> graph(V, arcs.size(), source, sink);
+        graph.attach(offsetData, heads, capacities, antiParallel, graphArcCount, std::move(storage));
+
+        arcs = {};
+        owners = {};
+        paired = false;
+        return graph;
+    }
+
+private:
+    const T V;
+    const T source;
+    const T sink;
+
+    std::vector<Edge<T, U>> arcs;
+
+    // owners[k] is k if arc k is the first arc between its two vertices, and
+    // that first arc otherwise
+    std::vector<T> owners;
+    std::size_t parallelArc{0};
+    bool paired{false};
+
+    void checkNotPaired() const
+    {
+        if (paired)
+        {
+            throw std::logic_error("Arcs can not be added after they are paired.");
+        }
+    }
+
+    // Finds the first arc between the same two vertices for every arc, and
+    // merges anti-parallel arcs into it.
+    void pairArcs(unsigned threadCount)
+    {
+        if (paired)
+            return;
+        paired = true;
+        threadCount = std::max(1u, threadCount);
+
+        const std::size_t arcCount = arcs.size();
+        std::vector<T> order(arcCount);
+        auto smallerEndpoint = [this](std::size_t k)
+        {
+            return std::min(arcs[k].u, arcs[k].v);
+        };
+        auto place = [&order](std::size_t k, T position)
+        {
+            order[position] = k;
+        };
+        std::vector<T> offsets = countingSort<T>(arcCount, V, smallerEndpoint, place, threadCount);
+
+        owners.resize(arcCount);
+        std::vector<std::size_t> parallelArcs(threadCount, arcCount);
+
+        // Every thread takes the vertices of about the same number of arcs
+        auto firstVertex = [&](unsigned id)
+        {
+            if (id == threadCount)
+                return V;
+            T position = partitionBegin(arcCount, id, threadCount);
+            return static_cast<T>(std::lower_bound(offsets.begin(), offsets.end() - 1, position) - offsets.begin());
+        };
+
+        auto pair = [&](unsigned id)
+        {
+            // The (larger endpoint, arc) pairs of one vertex, sorted so that
+            // the arcs between the same two vertices are adjacent and in the
+            // order added. Its size is the largest degree, not V.
+            std::vector<std::pair<T, T>> bucket;
+
+            for (T u = firstVertex(id); u < firstVertex(id + 1); ++u)
+            {
+                bucket.clear();
+                for (T i = offsets[u]; i < offsets[u + 1]; ++i)
+                {
+                    T k = order[i];
+                    bucket.emplace_back(std::max(arcs[k].u, arcs[k].v), k);
+                }
+                std::sort(bucket.begin(), bucket.end());
+
+                T first{0};
+                for (std::size_t i{0}; i < bucket.size(); ++i)
+                {
+                    T k = bucket[i].second;
+                    if (i == 0 || bucket[i].first != bucket[i - 1].first)
+                    {
+                        first = k;
+                        owners[k] = k;
+                        continue;
+                    }
+
+                    owners[k] = first;
+                    if (arcs[k].u == arcs[first].u)
+                        parallelArcs[id] = std::min<std::size_t>(parallelArcs[id], k);
+                    else
+                        arcs[first].antiParallelCapacity += arcs[k].capacity;
+                }
+            }
+        };
+        runInParallel(threadCount, pair);
+
+        parallelArc = *std::min_element(parallelArcs.begin(), parallelArcs.end());
+    }
+};
+
+#endif // GRAPH_BUILDER_H
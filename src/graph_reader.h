@@ -3,19 +3,163 @@
 
 #include <iostream>
 #include <fstream>
+#include <iterator>
 #include <string.h>
 #include <exception>
-#include <sstream>
 #include <string>
-#include <map>
+#include <string_view>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <type_traits>
 #include <utility>
 #include <algorithm>
-#include <unordered_set>
+#include <vector>
+#include <memory>
 #include "graph.h"
+#include "graph_builder.h"
+#include "grid_graph.h"
+#include "mapped_file.h"
+#include "parallel.h"
+#include "stats.h"
+
+// Splits a character buffer into lines, like getline on a stream. The lines
+// point into the buffer, nothing is copied.
+class LineReader
+{
+public:
+    LineReader(const char *begin, const char *end) : pos(begin), end(end) {}
+
+    bool getline(std::string_view &line)
+    {
+        if (pos == end)
+            return false;
+
+        const char *newline = static_cast<const char *>(memchr(pos, '\n', end - pos));
+        const char *lineEnd = newline != nullptr ? newline : end;
+        line = std::string_view(pos, lineEnd - pos);
+        pos = newline != nullptr ? newline + 1 : end;
+        return true;
+    }
 
-char getDesignator(std::stringstream &ss, int lineNumber)
+    const char *position() const { return pos; }
+
+private:
+    const char *pos;
+    const char *end;
+};
+
+// Extracts whitespace separated values from a line, like operator>> on a
+// std::stringstream. Numbers are scanned directly from the characters. Once
+// an extraction fails, fail() is set and all further extractions fail.
+class LineScanner
 {
-    std::string designatorString;
+public:
+    explicit LineScanner(std::string_view line) : pos(line.data()), end(line.data() + line.size()) {}
+
+    bool fail() const { return failed; }
+
+    LineScanner &operator>>(std::string_view &token)
+    {
+        skipWhitespace();
+        const char *begin = pos;
+        while (pos < end && !isWhitespace(*pos))
+            pos++;
+
+        token = std::string_view(begin, pos - begin);
+        failed = failed || token.empty();
+        return *this;
+    }
+
+    template <typename X>
+    LineScanner &operator>>(X &value)
+    {
+        static_assert(std::is_arithmetic<X>::value, "Only numbers and tokens can be extracted");
+
+        skipWhitespace();
+        if (!failed)
+        {
+            if constexpr (std::is_integral<X>::value)
+                failed = !scanInteger(value);
+            else
+                failed = !scanFloatingPoint(value);
+        }
+        return *this;
+    }
+
+private:
+    const char *pos;
+    const char *end;
+    bool failed{false};
+
+    static bool isWhitespace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+    }
+
+    void skipWhitespace()
+    {
+        while (pos < end && isWhitespace(*pos))
+            pos++;
+    }
+
+    // An optional sign followed by digits. Fails on overflow.
+    template <typename X>
+    bool scanInteger(X &value)
+    {
+        bool negative{false};
+        if (pos < end && (*pos == '+' || *pos == '-'))
+        {
+            negative = *pos == '-';
+            pos++;
+        }
+        if (pos == end || *pos < '0' || *pos > '9')
+            return false;
+
+        unsigned long long limit = std::numeric_limits<X>::max();
+        if (negative && std::is_signed<X>::value)
+            limit++;
+
+        unsigned long long magnitude{0};
+        bool overflow{false};
+        for (; pos < end && *pos >= '0' && *pos <= '9'; ++pos)
+        {
+            unsigned digit = *pos - '0';
+            if (magnitude > (limit - digit) / 10)
+                overflow = true;
+            else
+                magnitude = 10 * magnitude + digit;
+        }
+        if (overflow)
+            return false;
+
+        value = negative ? static_cast<X>(0 - magnitude) : static_cast<X>(magnitude);
+        return true;
+    }
+
+    template <typename X>
+    bool scanFloatingPoint(X &value)
+    {
+        // from_chars does not take a plus sign
+        if (pos < end && *pos == '+')
+        {
+            pos++;
+            if (pos < end && *pos == '-')
+                return false;
+        }
+
+        auto [next, error] = std::from_chars(pos, end, value);
+        if (error != std::errc())
+            return false;
+
+        pos = next;
+        return true;
+    }
+};
+
+char getDesignator(LineScanner &ss, long long lineNumber)
+{
+    std::string_view designatorString;
     ss >> designatorString;
 
     if (designatorString.length() != 1)
@@ -26,23 +170,175 @@ char getDesignator(std::stringstream &ss, int lineNumber)
     return designatorString[0];
 }
 
+// Returns the line number of arc k, counting from the line after
+// firstLine. Only used to report errors.
+long long lineOfArc(const char *begin, const char *end, long long firstLine, std::size_t k)
+{
+    LineReader reader(begin, end);
+    std::string_view line;
+    long long lineNumber{firstLine};
+    std::size_t arc{0};
+
+    while (reader.getline(line))
+    {
+        lineNumber++;
+        LineScanner ss(line);
+        std::string_view designator;
+        ss >> designator;
+        if (designator == "a" && arc++ == k)
+            break;
+    }
+    return lineNumber;
+}
+
+template <typename T, typename U>
+bool parseArcLine(std::string_view line, long long lineNumber, long long vertex_ct, long long &arcsLeft, T &src, T &dst, U &cap)
+{
+    LineScanner ss(line);
+
+    char designator = getDesignator(ss, lineNumber);
+
+    switch (designator)
+    {
+    case 'c':
+        return false;
+
+    case 'p':
+
+        throw std::logic_error("line " + std::to_string(lineNumber) +
+                               " : More than one problem line is not expected.");
+
+    case 'n':
+        throw std::logic_error("line " + std::to_string(lineNumber) +
+                               " : More than two node lines is not expected.");
+    case 'a':
+    {
+        if (--arcsLeft < 0)
+        {
+            throw std::logic_error("line " + std::to_string(lineNumber) +
+                                   " : More edges than indicated in the problem line");
+        }
+
+        ss >> src >> dst >> cap;
+
+        if (ss.fail())
+        {
+            throw std::logic_error("line " + std::to_string(lineNumber) +
+                                   " : Problem line incorrectly formatted.");
+        }
+
+        if (src <= 0 || src > vertex_ct || dst <= 0 || dst > vertex_ct)
+        {
+            throw std::logic_error("line " + std::to_string(lineNumber) +
+                                   " : Node numbers not correct.");
+        }
+
+        // DIMACS format is 1-indexed. Transform to 0-indexed:
+        --src;
+        --dst;
+        return true;
+    }
+
+    default:
+        throw std::logic_error("line " + std::to_string(lineNumber) +
+                               " : Unknown designator.");
+    }
+}
+
+// A part of the arc section of a file, which starts at the beginning of a
+// line, and the arcs read from it.
+template <typename T, typename U>
+struct ArcChunk
+{
+    const char *begin{nullptr};
+    const char *end{nullptr};
+
+    std::vector<Edge<T, U>> arcs;
+
+    // Number of lines before the first line with an error, or of all lines
+    long long lines{0};
+    bool failed{false};
+    std::string_view errorLine;
+};
+
+// Splits [begin, end) into count chunks of about the same size, which end
+// at line breaks.
+template <typename T, typename U>
+std::vector<ArcChunk<T, U>> splitArcSection(const char *begin, const char *end, unsigned count)
+{
+    std::vector<ArcChunk<T, U>> chunks(count);
+    const char *chunkBegin = begin;
+
+    for (unsigned id{0}; id < count; ++id)
+    {
+        const char *chunkEnd = std::max(chunkBegin, begin + partitionBegin(end - begin, id + 1, count));
+        if (chunkEnd > begin && chunkEnd < end && *(chunkEnd - 1) != '\n')
+        {
+            const char *newline = static_cast<const char *>(memchr(chunkEnd, '\n', end - chunkEnd));
+            chunkEnd = newline != nullptr ? newline + 1 : end;
+        }
+
+        chunks[id].begin = chunkBegin;
+        chunks[id].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+    return chunks;
+}
+
+// Reads the arcs of a chunk until the end or the first line with an error.
+// Arc lines are not counted against the problem line here.
+template <typename T, typename U>
+void parseArcChunk(ArcChunk<T, U> &chunk, long long vertex_ct, std::size_t expectedArcs)
+{
+    chunk.arcs.reserve(expectedArcs);
+
+    LineReader reader(chunk.begin, chunk.end);
+    std::string_view line;
+    long long arcsLeft = std::numeric_limits<long long>::max();
+    T src;
+    T dst;
+    U cap;
+
+    try
+    {
+        while (reader.getline(line))
+        {
+            if (parseArcLine(line, 0, vertex_ct, arcsLeft, src, dst, cap))
+            {
+                chunk.arcs.emplace_back(src, dst, cap);
+            }
+            chunk.lines++;
+        }
+    }
+    catch (const std::logic_error &)
+    {
+        chunk.failed = true;
+        chunk.errorLine = line;
+    }
+}
+
+// Reads a max flow problem in DIMACS format from the characters in
+// [begin, end). Error messages give the line number of the first error. The
+// arc lines are parsed, and the graph is built, on threadCount threads.
+// The times of parsing and building are stored in stats, if given.
 template <typename T, typename U, template <typename, typename> typename EdgeType>
-Graph<T, U> readGraph(std::ifstream &fileStream)
+Graph<T, U> readGraph(const char *begin, const char *end, unsigned threadCount = 1, Stats *stats = nullptr)
 {
+    Stopwatch parseStopwatch;
 
-    std::string line;
-    int vertex_ct{-1};
-    int edge_ct{-1};
+    LineReader reader(begin, end);
+    std::string_view line;
+    long long vertex_ct{-1};
+    long long edge_ct{-1};
 
-    int lineNumber{0};
+    long long lineNumber{0};
     char designator{'\0'};
-    std::string designatorString;
 
     // Read lines until the first "Problem line"
-    while (designator != 'p' && getline(fileStream, line))
+    while (designator != 'p' && reader.getline(line))
     {
         lineNumber++;
-        std::stringstream ss(line);
+        LineScanner ss(line);
 
         designator = getDesignator(ss, lineNumber);
 
@@ -56,7 +352,7 @@ Graph<T, U> readGraph(std::ifstream &fileStream)
                                    " : node or arc lines should not appear before problem line.");
         case 'p':
         {
-            std::string problemDesignator;
+            std::string_view problemDesignator;
             ss >> problemDesignator >> vertex_ct >> edge_ct;
 
             if (ss.fail())
@@ -77,6 +373,13 @@ Graph<T, U> readGraph(std::ifstream &fileStream)
                                        "Number of vertices and edges should be non-negative");
             }
 
+            // Arc indices go up to twice the number of edges
+            if (vertex_ct >= std::numeric_limits<T>::max() || edge_ct > std::numeric_limits<T>::max() / 2)
+            {
+                throw std::logic_error("line " + std::to_string(lineNumber) +
+                                       " : Too many vertices or edges for " + std::to_string(8 * sizeof(T)) + "-bit vertex ids");
+            }
+
             break;
         }
 
@@ -88,13 +391,13 @@ Graph<T, U> readGraph(std::ifstream &fileStream)
 
     // Read lines, until the two node lines are read.
 
-    int source{-1};
-    int sink{-1};
+    long long source{-1};
+    long long sink{-1};
 
-    while ((source == -1 or sink == -1) && getline(fileStream, line))
+    while ((source == -1 or sink == -1) && reader.getline(line))
     {
         lineNumber++;
-        std::stringstream ss(line);
+        LineScanner ss(line);
 
         designator = getDesignator(ss, lineNumber);
 
@@ -105,8 +408,8 @@ Graph<T, U> readGraph(std::ifstream &fileStream)
 
         case 'n':
         {
-            int id;
-            std::string which;
+            long long id{0};
+            std::string_view which;
             ss >> id >> which;
 
             // DIMACS format is 1-indexed. Transform to 0-indexed:
@@ -118,11 +421,11 @@ Graph<T, U> readGraph(std::ifstream &fileStream)
                                        " : Node line incorrectly formatted");
             }
 
-            if (!which.compare("s") && source == -1)
+            if (which == "s" && source == -1)
             {
                 source = id;
             }
-            else if (!which.compare("t") && sink == -1)
+            else if (which == "t" && sink == -1)
             {
                 sink = id;
             }
@@ -159,99 +462,463 @@ Graph<T, U> readGraph(std::ifstream &fileStream)
         throw std::logic_error("source node and/or sink node not set correctly.");
     }
 
-    Graph<T, U> graph(vertex_ct, edge_ct, source, sink);
-
     // Read rest of the file, which should include all the arch lines.
+    // It is split into chunks at line breaks, one per thread. Parallel arcs
+    // are looked for once all chunks are read.
 
-    std::vector<std::unordered_set<T>> created_edges(vertex_ct);
+    const char *arcsBegin = reader.position();
+    const long long arcsFirstLine = lineNumber;
+    threadCount = std::max(1u, threadCount);
 
-    while (getline(fileStream, line))
+    std::vector<ArcChunk<T, U>> chunks = splitArcSection<T, U>(arcsBegin, end, threadCount);
+    auto parse = [&](unsigned id)
     {
-        lineNumber++;
-        std::stringstream ss(line);
-
-        designator = getDesignator(ss, lineNumber);
-
-        switch (designator)
+        // Arcs are expected in proportion to the size of the chunk. An arc
+        // line takes at least 7 characters, which bounds the arcs when the
+        // problem line is wrong.
+        std::size_t size = chunks[id].end - chunks[id].begin;
+        std::size_t expectedArcs{0};
+        if (size > 0)
+            expectedArcs = std::min<std::size_t>(size / 7 + 1, static_cast<double>(edge_ct) * size / (end - arcsBegin) + 1);
+        parseArcChunk(chunks[id], vertex_ct, expectedArcs);
+    };
+    runInParallel(threadCount, parse);
+
+    // Find the first error in the file. The arcs before it are kept.
+    std::exception_ptr error;
+    std::size_t arcCount{0};
+    std::size_t chunkCount{0};
+
+    for (auto &chunk : chunks)
+    {
+        chunkCount++;
+        if (arcCount + chunk.arcs.size() > static_cast<std::size_t>(edge_ct))
         {
-        case 'c':
+            std::size_t k = edge_ct - arcCount;
+            error = std::make_exception_ptr(std::logic_error("line " + std::to_string(lineOfArc(chunk.begin, chunk.end, lineNumber, k)) +
+                                                             " : More edges than indicated in the problem line"));
+            chunk.arcs.resize(k);
+            arcCount += k;
             break;
+        }
 
-        case 'p':
+        arcCount += chunk.arcs.size();
+        lineNumber += chunk.lines;
 
-            throw std::logic_error("line " + std::to_string(lineNumber) +
-                                   " : More than one problem line is not expected.");
-
-        case 'n':
-            throw std::logic_error("line " + std::to_string(lineNumber) +
-                                   " : More than two node lines is not expected.");
-        case 'a':
+        if (chunk.failed)
         {
-            if (--edge_ct < 0)
-            {
-                throw std::logic_error("line " + std::to_string(lineNumber) +
-                                       " : More edges than indicated in the problem line");
-            }
-
+            // Parse the line again, with its line number, to get the error
+            long long arcsLeft = edge_ct - arcCount;
             T src;
             T dst;
             U cap;
-            ss >> src >> dst >> cap;
-
-            if (ss.fail())
+            try
             {
-                throw std::logic_error("line " + std::to_string(lineNumber) +
-                                       " : Problem line incorrectly formatted.");
+                parseArcLine(chunk.errorLine, lineNumber + 1, vertex_ct, arcsLeft, src, dst, cap);
             }
-
-            if (src <= 0 || src > vertex_ct || dst <= 0 || dst > vertex_ct)
+            catch (const std::logic_error &)
             {
-                throw std::logic_error("line " + std::to_string(lineNumber) +
-                                       " : Node numbers not correct.");
+                error = std::current_exception();
             }
+            break;
+        }
+    }
+    chunks.resize(chunkCount);
 
-            // DIMACS format is 1-indexed. Transform to 0-indexed:
-            --src;
-            --dst;
+    // Concatenate the arcs of the chunks in file order
+    std::vector<Edge<T, U>> arcs(arcCount);
+    std::vector<std::size_t> chunkOffsets(chunkCount + 1, 0);
+    for (std::size_t i{0}; i < chunkCount; ++i)
+    {
+        chunkOffsets[i + 1] = chunkOffsets[i] + chunks[i].arcs.size();
+    }
+
+    auto concatenate = [&](unsigned id)
+    {
+        for (std::size_t i = id; i < chunkCount; i += threadCount)
+        {
+            std::copy(chunks[i].arcs.begin(), chunks[i].arcs.end(), arcs.begin() + chunkOffsets[i]);
+            chunks[i] = ArcChunk<T, U>();
+        }
+    };
+    runInParallel(threadCount, concatenate);
+
+    if (stats)
+        stats->parseTime = parseStopwatch.stop();
+    Stopwatch buildStopwatch;
+
+    // A parallel edge before the first error is reported instead
+    GraphBuilder<T, U> builder(vertex_ct, source, sink);
+    builder.addArcs(std::move(arcs));
+    std::size_t parallelArc = builder.findParallelArc(threadCount);
+    if (parallelArc < arcCount)
+    {
+        throw std::logic_error("line " + std::to_string(lineOfArc(arcsBegin, end, arcsFirstLine, parallelArc)) +
+                               " : Parallel edges not allowed.");
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+
+    if (arcCount < static_cast<std::size_t>(edge_ct))
+    {
+        throw std::logic_error("Less edges than indicated in the problem line.");
+    }
+
+    Graph<T, U> graph = builder.build(threadCount);
+    if (stats)
+        stats->buildTime = buildStopwatch.stop();
+    return graph;
+}
+
+template <typename T, typename U, template <typename, typename> typename EdgeType>
+Graph<T, U> readGraph(std::ifstream &fileStream, unsigned threadCount = 1, Stats *stats = nullptr)
+{
+    std::string contents{std::istreambuf_iterator<char>(fileStream), std::istreambuf_iterator<char>()};
+    return readGraph<T, U, EdgeType>(contents.data(), contents.data() + contents.size(), threadCount, stats);
+}
+
+// Reads the file at path by mapping it into memory.
+template <typename T, typename U, template <typename, typename> typename EdgeType>
+Graph<T, U> readGraph(const std::string &path, unsigned threadCount = 1, Stats *stats = nullptr)
+{
+    MappedFile file(path);
+    return readGraph<T, U, EdgeType>(file.begin(), file.end(), threadCount, stats);
+}
+
+// Reads a grid problem from the characters in [begin, end). The format
+// follows DIMACS, with pixels numbered from 1 in the order of GridGraph:
+//
+//   c <comment>
+//   p grid <width> <height> <depth> <neighbours>
+//   t <pixel> <source capacity> <sink capacity>
+//   e <pixel> <neighbouring pixel> <capacity>
+//
+// The neighbours are 4 or 8 for a 2D grid, with depth 1, or 6 for a 3D grid.
+// Capacities of repeated lines add up, and missing lines mean no capacity.
+// The time of reading is stored in stats, if given.
+template <typename T, typename U>
+GridGraph<T, U> readGridGraph(const char *begin, const char *end, Stats *stats = nullptr)
+{
+    Stopwatch parseStopwatch;
 
-            // check if parallel edge exist
-            if (created_edges[src].count(dst) != 0)
+    LineReader reader(begin, end);
+    std::string_view line;
+    long long lineNumber{0};
+    std::unique_ptr<GridGraph<T, U>> grid;
+
+    auto error = [&lineNumber](const std::string &message)
+    {
+        return std::logic_error("line " + std::to_string(lineNumber) + " : " + message);
+    };
+
+    while (reader.getline(line))
+    {
+        lineNumber++;
+        LineScanner ss(line);
+        char designator = getDesignator(ss, lineNumber);
+
+        if (designator == 'c')
+            continue;
+
+        if (designator == 'p')
+        {
+            std::string_view problemDesignator;
+            long long width{0};
+            long long height{0};
+            long long depth{0};
+            int neighbours{0};
+            ss >> problemDesignator >> width >> height >> depth >> neighbours;
+
+            if (ss.fail() || problemDesignator != "grid")
+                throw error("Grid problem line incorrectly formatted");
+            if (grid)
+                throw error("More than one problem line is not expected.");
+            if (width <= 0 || height <= 0 || depth <= 0 ||
+                static_cast<long double>(width) * height * depth >= std::numeric_limits<T>::max())
             {
-                throw std::logic_error("line " + std::to_string(lineNumber) +
-                                       " : Parallel edges not allowed.");
+                throw error("Grid sides must be positive and fit the vertex ids");
             }
 
-            // If anti-parallel edge exist: Updage edge.
-            if (created_edges[dst].count(src) != 0)
+            try
             {
-                auto it = find_if(graph.adj_list[src].begin(), graph.adj_list[src].end(),
-                                  [dst](auto e)
-                                  { return e->v == dst; });
-
-                (*it)->capacity += cap;
+                grid = std::make_unique<GridGraph<T, U>>(width, height, depth, neighbours);
+            }
+            catch (const std::logic_error &e)
+            {
+                throw error(e.what());
             }
+            continue;
+        }
+
+        if (!grid)
+            throw error("pixel lines should not appear before problem line.");
+
+        long long pixel{0};
+        ss >> pixel;
+        if (designator == 't')
+        {
+            U sourceCapacity{0};
+            U sinkCapacity{0};
+            ss >> sourceCapacity >> sinkCapacity;
+            if (ss.fail())
+                throw error("Terminal line incorrectly formatted.");
+            if (pixel <= 0 || pixel > grid->pixels)
+                throw error("Pixel numbers not correct.");
+
+            grid->sourceCapacities[pixel - 1] += sourceCapacity;
+            grid->sinkCapacities[pixel - 1] += sinkCapacity;
+        }
+        else if (designator == 'e')
+        {
+            long long other{0};
+            U capacity{0};
+            ss >> other >> capacity;
+            if (ss.fail())
+                throw error("Neighbour line incorrectly formatted.");
+            if (pixel <= 0 || pixel > grid->pixels || other <= 0 || other > grid->pixels)
+                throw error("Pixel numbers not correct.");
+
+            int d = grid->findDirection(pixel - 1, other - 1);
+            if (d < 0)
+                throw error("Pixels " + std::to_string(pixel) + " and " + std::to_string(other) + " are not neighbours.");
+            grid->neighbourCapacities[static_cast<std::size_t>(d) * grid->pixels + pixel - 1] += capacity;
+        }
+        else
+        {
+            throw error("Unknown designator");
+        }
+    }
+
+    if (!grid)
+    {
+        throw std::logic_error("No grid problem line.");
+    }
+
+    if (stats)
+        stats->parseTime = parseStopwatch.stop();
+    return std::move(*grid);
+}
+
+// Reads the grid problem in the file at path by mapping it into memory
+template <typename T, typename U>
+GridGraph<T, U> readGridGraph(const std::string &path, Stats *stats = nullptr)
+{
+    MappedFile file(path);
+    return readGridGraph<T, U>(file.begin(), file.end(), stats);
+}
 
-            // no parallel or anti_parallel edge exist: create new edge
+// Returns true if the first problem line in [begin, end) is that of a grid problem
+inline bool isGridProblem(const char *begin, const char *end)
+{
+    LineReader reader(begin, end);
+    std::string_view line;
+    while (reader.getline(line))
+    {
+        LineScanner ss(line);
+        std::string_view designator;
+        std::string_view problemDesignator;
+        ss >> designator;
+        if (designator == "p")
+        {
+            ss >> problemDesignator;
+            return problemDesignator == "grid";
+        }
+    }
+    return false;
+}
+
+inline bool isGridProblem(const std::string &path)
+{
+    MappedFile file(path);
+    return isGridProblem(file.begin(), file.end());
+}
+
+// Sizes and capacities of a DIMACS or grid problem, found by a quick pass
+// over the file before it is read, to choose the types of its graph. Lines
+// that can not be read are skipped here, and reported by readGraph() or
+// readGridGraph().
+struct ProblemProfile
+{
+    long long vertexCount{0};
+    long long edgeCount{0};
+    bool integralCapacities{true};
+
+    // Sum of the capacities, up to the largest unsigned long long. No flow,
+    // excess or residual capacity can exceed it.
+    unsigned long long capacitySum{0};
+
+    // Arcs from or to the source or the sink, whose capacities lambdas
+    // change, if counted. All arcs count if the terminals are not given on
+    // n lines between the problem line and the arcs.
+    unsigned long long terminalArcCount{0};
+
+    // Makes room for the parametric problem at the lambdas, which change the
+    // capacity of every terminal arc by at most the largest |lambda|, and
+    // need floating point capacities if one is not an integer
+    void addLambdas(const std::vector<double> &lambdas)
+    {
+        for (double lambda : lambdas)
+        {
+            if (lambda != std::floor(lambda))
+                integralCapacities = false;
+
+            double increase = std::ceil(std::fabs(lambda)) * static_cast<double>(terminalArcCount);
+            const double largest = static_cast<double>(std::numeric_limits<unsigned long long>::max());
+            if (increase >= largest - static_cast<double>(capacitySum))
+                capacitySum = std::numeric_limits<unsigned long long>::max();
             else
+                capacitySum += static_cast<unsigned long long>(increase);
+        }
+    }
+
+    // Vertex ids and arc indices do not fit in 32 bits
+    bool needsWideIds() const
+    {
+        return vertexCount >= std::numeric_limits<int>::max() || edgeCount > std::numeric_limits<int>::max() / 2;
+    }
+
+    // Flow values may not fit in 32 bits
+    bool needsWideCapacities() const
+    {
+        return capacitySum > static_cast<unsigned long long>(std::numeric_limits<int>::max());
+    }
+
+    // Flow values may not fit in 64 bits, or are not integers
+    bool needsFloatingCapacities() const
+    {
+        return !integralCapacities || capacitySum > static_cast<unsigned long long>(std::numeric_limits<long long>::max());
+    }
+};
+
+// Profiles the problem in [begin, end) on threadCount threads. Only the
+// problem line and the capacity of every arc line are scanned, and the
+// endpoints too if countTerminalArcs is set.
+inline ProblemProfile profileProblem(const char *begin, const char *end, unsigned threadCount = 1, bool countTerminalArcs = false)
+{
+    ProblemProfile profile;
+    LineReader reader(begin, end);
+    std::string_view line;
+    long long source{0};
+    long long sink{0};
+    while (reader.getline(line))
+    {
+        LineScanner ss(line);
+        std::string_view designator;
+        ss >> designator;
+        if (designator == "p")
+        {
+            std::string_view problemDesignator;
+            ss >> problemDesignator;
+            if (problemDesignator != "grid")
             {
-                graph.addEdge(src, dst, cap);
-                created_edges[src].insert(dst);
+                ss >> profile.vertexCount >> profile.edgeCount;
+
+                // The terminals, from the n and comment lines before the arcs
+                for (const char *next = reader.position(); reader.getline(line); next = reader.position())
+                {
+                    LineScanner terminal(line);
+                    std::string_view kind;
+                    long long id{0};
+                    terminal >> designator;
+                    if (terminal.fail() || designator == "c")
+                        continue;
+                    terminal >> id >> kind;
+                    if (designator != "n" || terminal.fail())
+                    {
+                        reader = LineReader(next, end);
+                        break;
+                    }
+                    if (kind == "s")
+                        source = id;
+                    else if (kind == "t")
+                        sink = id;
+                }
+                break;
             }
+
+            // Arc ids of a grid go up to 18 per pixel
+            long long width{0};
+            long long height{0};
+            long long depth{0};
+            ss >> width >> height >> depth;
+            double pixels = static_cast<double>(width) * height * depth;
+            profile.vertexCount = static_cast<long long>(std::min(pixels + 2, 1e18));
+            profile.edgeCount = static_cast<long long>(std::min(9 * pixels, 1e18));
             break;
         }
+    }
 
-        default:
-            throw std::logic_error("line " + std::to_string(lineNumber) +
-                                   " : Unknown designator.");
+    const bool terminalsKnown = source > 0 && sink > 0;
+    threadCount = std::max(1u, threadCount);
+    auto chunks = splitArcSection<long long, double>(reader.position(), end, threadCount);
+    std::vector<ProblemProfile> profiles(threadCount);
+
+    auto scan = [&](unsigned id)
+    {
+        LineReader chunkReader(chunks[id].begin, chunks[id].end);
+        std::string_view line;
+        ProblemProfile &local = profiles[id];
+
+        auto isTerminal = [source, sink](std::string_view vertex)
+        {
+            long long id{0};
+            std::from_chars(vertex.data(), vertex.data() + vertex.size(), id);
+            return id == source || id == sink;
+        };
+
+        auto add = [&local](std::string_view capacity)
+        {
+            if (capacity[0] == '+' || capacity[0] == '-')
+                capacity.remove_prefix(1);
+            unsigned long long value{0};
+            auto [next, error] = std::from_chars(capacity.data(), capacity.data() + capacity.size(), value);
+            if (next != capacity.data() + capacity.size())
+                local.integralCapacities = false;
+            else if (error == std::errc::result_out_of_range)
+                local.capacitySum = std::numeric_limits<unsigned long long>::max();
+            else if (error == std::errc())
+                local.capacitySum += std::min(value, std::numeric_limits<unsigned long long>::max() - local.capacitySum);
+        };
+
+        // Arc lines and the neighbour lines of grids have one capacity,
+        // the terminal lines of grids two
+        while (chunkReader.getline(line))
+        {
+            LineScanner ss(line);
+            std::string_view designator, first, second, third;
+            ss >> designator;
+            if (designator != "a" && designator != "e" && designator != "t")
+                continue;
+            ss >> first >> second >> third;
+            if (ss.fail())
+                continue;
+
+            if (designator == "t")
+                add(second);
+            add(third);
+
+            if (countTerminalArcs && designator == "a" && (!terminalsKnown || isTerminal(first) || isTerminal(second)))
+                local.terminalArcCount++;
         }
-    }
+    };
+    runInParallel(threadCount, scan);
 
-    if (edge_ct > 0)
+    for (const auto &local : profiles)
     {
-        throw std::logic_error("Less edges than indicated in the problem line.");
+        profile.integralCapacities = profile.integralCapacities && local.integralCapacities;
+        profile.capacitySum += std::min(local.capacitySum, std::numeric_limits<unsigned long long>::max() - profile.capacitySum);
+        profile.terminalArcCount += local.terminalArcCount;
     }
+    return profile;
+}
 
-    return graph;
+inline ProblemProfile profileProblem(const std::string &path, unsigned threadCount = 1, bool countTerminalArcs = false)
+{
+    MappedFile file(path);
+    return profileProblem(file.begin(), file.end(), threadCount, countTerminalArcs);
 }
 
-#endif
\ No newline at end of file
+#endif
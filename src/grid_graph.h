@@ -0,0 +1,271 @@
+#ifndef GRID_GRAPH_H
+#define GRID_GRAPH_H
+
+#include "graph.h"
+#include "graph_builder.h"
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+// Graph of a width x height x depth grid of pixels, as in image
+// segmentation, where every pixel has arcs to the same stencil of 4, 8 (in
+// 2D) or 6 (in 3D) neighbours and to both terminals. Neighbours are computed
+// from the pixel ids, so only the capacities are stored: one plane of
+// capacities per stencil direction, and the terminal capacities.
+//
+// Pixel p = x + width * (y + height * z) is vertex p, the source is vertex
+// pixels and the sink vertex pixels + 1. The arcs of pixel p are
+// [p * stride, p * stride + neighbours + 2): one arc per direction, then the
+// arcs to the source and to the sink. The stride, 8 or 16, is a power of
+// two, so the pixel and direction of an arc are found by a shift and a mask.
+// The arcs of the source to every pixel, and then those of the sink, follow
+// the pixel arcs.
+//
+// Arcs in directions that leave the grid wrap around, modulo the pixel
+// count, to some other pixel. Both arcs of such a pair have no capacity, so
+// they carry no flow, but solvers can scan them like any other arc.
+//
+// GridGraph has the arc interface of Graph: arcCount, firstArc, endArc,
+// head, reverse, capacity and copyCapacities. Solvers written against it
+// run on both.
+template <typename T, typename U>
+class GridGraph
+{
+public:
+    const T width;
+    const T height;
+    const T depth;
+    const int neighbours;
+    const T pixels;
+    const T V;
+    const T source;
+    const T sink;
+
+    // neighbourCapacities[d * pixels + p] is the capacity of the arc from p
+    // to its neighbour in direction d
+    std::vector<U> neighbourCapacities;
+    std::vector<U> sourceCapacities;
+    std::vector<U> sinkCapacities;
+
+    GridGraph(T width, T height, T depth, int neighbours)
+        : width(width), height(height), depth(depth), neighbours(neighbours),
+          pixels(checkedPixelCount(width, height, depth, neighbours)), V(pixels + 2), source(pixels), sink(pixels + 1),
+          neighbourCapacities(static_cast<std::size_t>(neighbours) * pixels, 0),
+          sourceCapacities(pixels, 0), sinkCapacities(pixels, 0)
+    {
+        shift = neighbours == 8 ? 4 : 3;
+        mask = (T{1} << shift) - 1;
+        terminalArcs = pixels << shift;
+
+        // Offsets are kept in [0, pixels), so a neighbour is found with one
+        // wrap-around. The arcs of opposite directions d and d ^ 1 pair up.
+        const long long plane = static_cast<long long>(width) * height;
+        for (int d{0}; d < neighbours; ++d)
+        {
+            const int *step = steps(d);
+            long long offset = step[0] + step[1] * static_cast<long long>(width) + step[2] * plane;
+            offsets[d] = ((offset % pixels) + pixels) % pixels;
+        }
+    }
+
+    // Sets the capacity of the arc from p to its neighbour in direction d
+    void setNeighbourCapacity(T p, int d, U capacity)
+    {
+        if (d < 0 || d >= neighbours || !hasNeighbour(p, d))
+        {
+            throw std::logic_error("Pixel " + std::to_string(p) + " has no neighbour in direction " + std::to_string(d));
+        }
+        neighbourCapacities[static_cast<std::size_t>(d) * pixels + p] = capacity;
+    }
+
+    // Returns the direction from p to q, or -1 if q is not a neighbour of p
+    int findDirection(T p, T q) const
+    {
+        for (int d{0}; d < neighbours; ++d)
+        {
+            if (hasNeighbour(p, d) && neighbour(p, d) == q)
+                return d;
+        }
+        return -1;
+    }
+
+    // Returns true if the neighbour of p in direction d is inside the grid
+    bool hasNeighbour(T p, int d) const
+    {
+        const int *step = steps(d);
+        long long x = p % width + step[0];
+        long long y = p / width % height + step[1];
+        long long z = p / width / height + step[2];
+        return x >= 0 && x < width && y >= 0 && y < height && z >= 0 && z < depth;
+    }
+
+    T arcCount() const
+    {
+        return terminalArcs + 2 * pixels;
+    }
+
+    T firstArc(T u) const
+    {
+        if (u < pixels)
+            return u << shift;
+        return terminalArcs + (u - pixels) * pixels;
+    }
+
+    T endArc(T u) const
+    {
+        if (u < pixels)
+            return (u << shift) + neighbours + 2;
+        return terminalArcs + (u - pixels + 1) * pixels;
+    }
+
+    T head(T e) const
+    {
+        if (e >= terminalArcs)
+        {
+            T p = e - terminalArcs;
+            return p < pixels ? p : p - pixels;
+        }
+
+        T p = e >> shift;
+        int d = e & mask;
+        if (d < neighbours)
+            return neighbour(p, d);
+        return d == neighbours ? source : sink;
+    }
+
+    T reverse(T e) const
+    {
+        if (e >= terminalArcs)
+        {
+            T p = e - terminalArcs;
+            return p < pixels ? (p << shift) + neighbours : ((p - pixels) << shift) + neighbours + 1;
+        }
+
+        T p = e >> shift;
+        int d = e & mask;
+        if (d < neighbours)
+            return (neighbour(p, d) << shift) + (d ^ 1);
+        return terminalArcs + (d - neighbours) * pixels + p;
+    }
+
+    U capacity(T e) const
+    {
+        if (e >= terminalArcs)
+            return e - terminalArcs < pixels ? sourceCapacities[e - terminalArcs] : 0;
+
+        T p = e >> shift;
+        int d = e & mask;
+        if (d < neighbours)
+            return neighbourCapacities[static_cast<std::size_t>(d) * pixels + p];
+        return d == neighbours ? 0 : sinkCapacities[p];
+    }
+
+    // Sets capacities to the capacity of every arc. Arc ids between the arcs
+    // of two pixels are not used, and get no capacity.
+    void copyCapacities(std::vector<U> &capacities) const
+    {
+        capacities.assign(arcCount(), 0);
+        for (int d{0}; d < neighbours; ++d)
+        {
+            const U *plane = neighbourCapacities.data() + static_cast<std::size_t>(d) * pixels;
+            for (T p{0}; p < pixels; ++p)
+                capacities[(p << shift) + d] = plane[p];
+        }
+        for (T p{0}; p < pixels; ++p)
+        {
+            capacities[(p << shift) + neighbours + 1] = sinkCapacities[p];
+            capacities[terminalArcs + p] = sourceCapacities[p];
+        }
+    }
+
+private:
+    // Steps in x, y and z of the directions of the 2D and the 3D stencils.
+    // Directions 2k and 2k + 1 are opposite.
+    static constexpr int planeSteps[8][3] = {
+        {1, 0, 0},
+        {-1, 0, 0},
+        {0, 1, 0},
+        {0, -1, 0},
+        {1, 1, 0},
+        {-1, -1, 0},
+        {1, -1, 0},
+        {-1, 1, 0},
+    };
+    static constexpr int volumeSteps[6][3] = {
+        {1, 0, 0},
+        {-1, 0, 0},
+        {0, 1, 0},
+        {0, -1, 0},
+        {0, 0, 1},
+        {0, 0, -1},
+    };
+
+    const int *steps(int d) const
+    {
+        return neighbours == 6 ? volumeSteps[d] : planeSteps[d];
+    }
+
+    // Distance to the neighbour in every direction, modulo the pixel count
+    T offsets[8]{};
+    int shift{0};
+    T mask{0};
+
+    // First arc of the source
+    T terminalArcs{0};
+
+    T neighbour(T p, int d) const
+    {
+        T q = p + offsets[d];
+        return q >= pixels ? q - pixels : q;
+    }
+
+    static T checkedPixelCount(T width, T height, T depth, int neighbours)
+    {
+        if (neighbours != 4 && neighbours != 6 && neighbours != 8)
+        {
+            throw std::logic_error("A grid has 4, 6 or 8 neighbours per pixel, not " + std::to_string(neighbours));
+        }
+        if (width <= 0 || height <= 0 || depth <= 0 || (neighbours != 6 && depth != 1))
+        {
+            throw std::logic_error("Grid sides must be positive, and only grids with 6 neighbours have depth");
+        }
+
+        // Arc ids go up to 16 per pixel, plus the terminal arcs
+        long double arcs = static_cast<long double>(width) * height * depth * ((neighbours == 8 ? 16 : 8) + 2);
+        if (arcs >= std::numeric_limits<T>::max())
+        {
+            throw std::logic_error("Too many pixels for " + std::to_string(8 * sizeof(T)) + "-bit vertex ids");
+        }
+        return width * height * depth;
+    }
+};
+
+// Returns the grid as a graph in CSR format, for the solvers that only run
+// on Graph. Only arcs inside the grid are added.
+template <typename T, typename U>
+Graph<T, U> gridToGraph(const GridGraph<T, U> &grid, unsigned threadCount = 1)
+{
+    GraphBuilder<T, U> builder(grid.V, grid.source, grid.sink);
+    builder.reserve(static_cast<std::size_t>(grid.pixels) * (grid.neighbours + 2));
+    for (T p{0}; p < grid.pixels; ++p)
+    {
+        if (grid.sourceCapacities[p] > 0)
+            builder.addArc(grid.source, p, grid.sourceCapacities[p]);
+        if (grid.sinkCapacities[p] > 0)
+            builder.addArc(p, grid.sink, grid.sinkCapacities[p]);
+
+        // Each neighbour pair once, from its first direction
+        for (int d{0}; d < grid.neighbours; d += 2)
+        {
+            if (!grid.hasNeighbour(p, d))
+                continue;
+            T e = grid.firstArc(p) + d;
+            builder.addArc(p, grid.head(e), grid.capacity(e));
+            builder.addArc(grid.head(e), p, grid.capacity(grid.reverse(e)));
+        }
+    }
+    return builder.build(threadCount);
+}
+
+#endif // GRID_GRAPH_H
@@ -0,0 +1,73 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <stdexcept>
+#include <cstddef>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A file mapped into memory. The contents are accessed in place, without
+// copying them into a buffer first. A copy-on-write mapping may be written
+// to: the written pages become private copies and the file is unchanged.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path, bool copyOnWrite = false, int advice = MADV_SEQUENTIAL)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1)
+        {
+            throw std::runtime_error("could not open or read from file " + path);
+        }
+
+        struct stat status;
+        if (fstat(fd, &status) == -1)
+        {
+            close(fd);
+            throw std::runtime_error("could not open or read from file " + path);
+        }
+        size = status.st_size;
+
+        // An empty file can not be mapped
+        if (size > 0)
+        {
+            int protection = copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+            void *mapping = mmap(nullptr, size, protection, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED)
+            {
+                close(fd);
+                throw std::runtime_error("could not open or read from file " + path);
+            }
+            data = static_cast<char *>(mapping);
+            madvise(mapping, size, advice);
+        }
+
+        // The mapping stays valid after the file is closed
+        close(fd);
+    }
+
+    ~MappedFile()
+    {
+        if (data != nullptr)
+            munmap(data, size);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *begin() const { return data; }
+    const char *end() const { return data + size; }
+    std::size_t length() const { return size; }
+
+    // Writable only for a copy-on-write mapping
+    char *mutableData() { return data; }
+
+private:
+    char *data{nullptr};
+    std::size_t size{0};
+};
+
+#endif // MAPPED_FILE_H
@@ -1,50 +1,133 @@
-
 #include "command_line_parser.h"
 #include "graph_reader.h"
+#include "binary_graph.h"
 #include "solver.h"
 #include <iostream>
 #include <fstream>
 
-int main(int argc, char *argv[])
+// Types of the graph arrays. Narrow types are used when the problem fits
+// them, since they keep more of the graph in cache.
+enum class IndexType
 {
+    int32,
+    int64,
+};
 
-    CommandLineParser parser{};
+enum class CapacityType
+{
+    int32,
+    int64,
+    float64,
+};
+
+// Reads a grid problem and solves it as a grid, without building a Graph
+template <typename T, typename U>
+int runGrid(const CommandLineParser &parser, const char *program, Stats stats)
+{
+    const SolverOptions &options = parser.getOptions();
+    std::unique_ptr<GridGraph<T, U>> gridPointer;
 
     try
     {
-        parser.parse(argc, argv);
+        if (parser.isConvert() || !options.lambdas.empty() || options.vertexOrder != VertexOrder::none)
+        {
+            throw std::logic_error("Grid problems can not be converted, reordered or solved for lambdas");
+        }
+
+        // The time of profiling the file counts as parsing
+        std::chrono::microseconds profileTime = stats.parseTime;
+        gridPointer = std::make_unique<GridGraph<T, U>>(readGridGraph<T, U>(parser.getFilePath(), &stats));
+        stats.parseTime += profileTime;
     }
-    catch (const HelpException &e)
+    catch (const std::runtime_error &e)
     {
-        // The user asked for help, so we exit successfully
-        return EXIT_SUCCESS;
+        // The file could not be opened
+        std::cerr << "Error: " << e.what() << "\n\n";
+        parser.printUsage(program);
+        return EXIT_FAILURE;
     }
-    catch (const std::invalid_argument &e)
+    catch (const std::exception &e)
     {
-        // A command line invalid argument was provided
-        std::cerr << "Error: " << e.what() << std::endl;
-        parser.printUsage(argv[0]);
+        std::cerr << "Error: " << e.what() << '\n';
         return EXIT_FAILURE;
     }
 
-    std::ifstream fileStream(parser.getFilePath());
-
-    if (!fileStream)
+    try
     {
-        std::cerr << "Error: could not open or read from file " << parser.getFilePath() << "\n\n";
-        parser.printUsage(argv[0]);
-        return EXIT_FAILURE;
+        if (options.valueOnly)
+        {
+            // hipr runs on the grid converted to a Graph, and the conversion counts as building
+            Stopwatch buildStopwatch;
+            const Graph<T, U> graph = gridToGraph(*gridPointer, options.threadCount ? options.threadCount : defaultThreadCount());
+            stats.buildTime += buildStopwatch.stop();
+            solveValueOnly(&graph, options, stats);
+        }
+        else
+            solve(parser.getAlgorithm(), gridPointer.get(), options, stats);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << '\n';
     }
 
-    std::unique_ptr<Graph<int, int>> graphPointer;
+    return EXIT_SUCCESS;
+}
+
+// Reads the graph with vertex ids of type T and capacities of type U, and
+// converts or solves it.
+template <typename T, typename U>
+int run(const CommandLineParser &parser, const char *program, Stats stats)
+{
+    std::unique_ptr<Graph<T, U>> graphPointer;
+    VertexReordering<T> reordering;
 
     try
     {
-        // Read the graph data from the file and construct a Graph<int, int> object.
-        Graph<int, int> graphObj = readGraph<int, int, Edge>(fileStream);
+        if (!isBinaryGraph(parser.getFilePath()) && isGridProblem(parser.getFilePath()))
+            return runGrid<T, U>(parser, program, stats);
+
+        // A binary graph is solved straight from the mapped file
+        if (!parser.isConvert() && isBinaryGraph(parser.getFilePath()))
+        {
+            Stopwatch loadStopwatch;
+            graphPointer = std::make_unique<Graph<T, U>>(readBinaryGraph<T, U>(parser.getFilePath(), parser.isVerify()));
+            stats.parseTime = loadStopwatch.stop();
+        }
+        else
+        {
+            // Read the graph data from the file and construct a Graph<T, U> object.
+            // The arc lines are parsed on the same number of threads as the solver uses.
+            // The time of profiling the file counts as parsing.
+            unsigned threadCount = parser.getOptions().threadCount ? parser.getOptions().threadCount : defaultThreadCount();
+            std::chrono::microseconds profileTime = stats.parseTime;
+            Graph<T, U> graphObj = readGraph<T, U, Edge>(parser.getFilePath(), threadCount, &stats);
+            stats.parseTime += profileTime;
 
-        // Move the constructed Graph object into a unique_ptr.
-        graphPointer = std::make_unique<Graph<int, int>>(std::move(graphObj));
+            // Move the constructed Graph object into a unique_ptr.
+            graphPointer = std::make_unique<Graph<T, U>>(std::move(graphObj));
+        }
+
+        if (parser.isConvert())
+        {
+            writeBinaryGraph(*graphPointer, parser.getOutputPath());
+            return EXIT_SUCCESS;
+        }
+
+        // Renumber the vertices for locality. The graph as read is freed.
+        if (parser.getOptions().vertexOrder != VertexOrder::none)
+        {
+            Stopwatch reorderStopwatch;
+            unsigned threadCount = parser.getOptions().threadCount ? parser.getOptions().threadCount : defaultThreadCount();
+            graphPointer = std::make_unique<Graph<T, U>>(reorderVertices(*graphPointer, parser.getOptions().vertexOrder, reordering, threadCount));
+            stats.reorderTime = reorderStopwatch.stop();
+        }
+    }
+    catch (const std::runtime_error &e)
+    {
+        // The file could not be opened or written
+        std::cerr << "Error: " << e.what() << "\n\n";
+        parser.printUsage(program);
+        return EXIT_FAILURE;
     }
     catch (const std::exception &e)
     {
@@ -54,7 +137,12 @@ int main(int argc, char *argv[])
 
     try
     {
-        solve(parser.getAlgorithm(), graphPointer.get());
+        if (!parser.getOptions().lambdas.empty())
+            solveParametricProblem(graphPointer.get(), parser.getOptions(), reordering.order.empty() ? nullptr : &reordering);
+        else if (parser.getOptions().valueOnly)
+            solveValueOnly(graphPointer.get(), parser.getOptions(), stats, reordering.order.empty() ? nullptr : &reordering);
+        else
+            solve(parser.getAlgorithm(), graphPointer.get(), parser.getOptions(), stats);
     }
     catch (const std::exception &e)
     {
@@ -63,3 +151,99 @@ int main(int argc, char *argv[])
 
     return EXIT_SUCCESS;
 }
+
+template <typename T>
+int runWithCapacityType(CapacityType capacityType, const CommandLineParser &parser, const char *program, Stats stats)
+{
+    switch (capacityType)
+    {
+    case CapacityType::int32:
+        return run<T, int>(parser, program, stats);
+    case CapacityType::int64:
+        return run<T, long long>(parser, program, stats);
+    default:
+        return run<T, double>(parser, program, stats);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+
+    CommandLineParser parser{};
+
+    try
+    {
+        parser.parse(argc, argv);
+    }
+    catch (const HelpException &e)
+    {
+        // The user asked for help, so we exit successfully
+        return EXIT_SUCCESS;
+    }
+    catch (const std::invalid_argument &e)
+    {
+        // A command line invalid argument was provided
+        std::cerr << "Error: " << e.what() << std::endl;
+        parser.printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    IndexType indexType{IndexType::int32};
+    CapacityType capacityType{CapacityType::int32};
+    Stats stats;
+
+    try
+    {
+        if (parser.isVerify() && (parser.isConvert() || !isBinaryGraph(parser.getFilePath())))
+        {
+            throw std::logic_error("--verify only applies to binary graph files");
+        }
+
+        // A binary graph has the types it was written with. For a DIMACS file,
+        // the types are chosen from the problem line and the capacities.
+        if (!parser.isConvert() && isBinaryGraph(parser.getFilePath()))
+        {
+            BinaryGraphHeader header = readBinaryGraphHeader(parser.getFilePath());
+            if ((header.indexSize != 4 && header.indexSize != 8) ||
+                (header.floatingCapacities ? header.capacitySize != 8 : header.capacitySize != 4 && header.capacitySize != 8))
+            {
+                throw std::logic_error(parser.getFilePath() + ": the types of the binary graph are not supported");
+            }
+            indexType = header.indexSize == 8 ? IndexType::int64 : IndexType::int32;
+            if (header.floatingCapacities)
+                capacityType = CapacityType::float64;
+            else if (header.capacitySize == 8)
+                capacityType = CapacityType::int64;
+        }
+        else
+        {
+            Stopwatch profileStopwatch;
+            unsigned threadCount = parser.getOptions().threadCount ? parser.getOptions().threadCount : defaultThreadCount();
+            ProblemProfile profile = profileProblem(parser.getFilePath(), threadCount, !parser.getOptions().lambdas.empty());
+            profile.addLambdas(parser.getOptions().lambdas);
+            stats.parseTime = profileStopwatch.stop();
+
+            indexType = profile.needsWideIds() ? IndexType::int64 : IndexType::int32;
+            if (profile.needsFloatingCapacities())
+                capacityType = CapacityType::float64;
+            else if (profile.needsWideCapacities())
+                capacityType = CapacityType::int64;
+        }
+    }
+    catch (const std::runtime_error &e)
+    {
+        // The file could not be opened
+        std::cerr << "Error: " << e.what() << "\n\n";
+        parser.printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    if (indexType == IndexType::int64)
+        return runWithCapacityType<long long>(capacityType, parser, argv[0], stats);
+    return runWithCapacityType<int>(capacityType, parser, argv[0], stats);
+}
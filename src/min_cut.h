@@ -0,0 +1,74 @@
+#ifndef MIN_CUT_H
+#define MIN_CUT_H
+
+#include "graph.h"
+#include <vector>
+#include <type_traits>
+
+// Returns the source side of a minimum cut: the vertices that can not reach
+// the sink in the residual graph given by capacities. Valid for the residual
+// capacities of a solver that has found a maximum flow or a maximum preflow.
+// The graph may be a Graph or a GridGraph.
+template <typename G, typename U>
+std::vector<bool> findMinCut(const G &graph, const std::vector<U> &capacities)
+{
+    using T = std::remove_const_t<decltype(graph.V)>;
+    std::vector<bool> sourceSide(graph.V, true);
+    sourceSide[graph.sink] = false;
+
+    // Reverse BFS from the sink
+    std::vector<T> queue{graph.sink};
+    for (std::size_t i{0}; i < queue.size(); ++i)
+    {
+        T v = queue[i];
+        for (T e = graph.firstArc(v); e < graph.endArc(v); ++e)
+        {
+            T w = graph.head(e);
+            if (sourceSide[w] && capacities[graph.reverse(e)] > 0)
+            {
+                sourceSide[w] = false;
+                queue.push_back(w);
+            }
+        }
+    }
+
+    return sourceSide;
+}
+
+// Returns the lowest capacity of the cuts with source side
+// S_k = {v : ranks[v] <= k}, for ranks[source] <= k < ranks[sink], in the
+// capacities of the graph. Every such cut bounds the max flow value from
+// above. Ranks are in [0, rankCount); BFS levels from the source and
+// push-relabel heights counted down from the top are such rankings, with
+// unreached or dead vertices on the sink or the source side.
+template <typename U, typename G, typename T>
+U findBestThresholdCut(const G &graph, const std::vector<T> &ranks, T rankCount)
+{
+    // Arc u->v crosses the cuts S_k for ranks[u] <= k < ranks[v], so the
+    // capacities of all cuts are the prefix sums of their changes
+    std::vector<U> changes(static_cast<std::size_t>(rankCount) + 1, 0);
+    for (T u{0}; u < graph.V; ++u)
+    {
+        for (T e = graph.firstArc(u); e < graph.endArc(u); ++e)
+        {
+            T v = graph.head(e);
+            if (ranks[u] < ranks[v])
+            {
+                changes[ranks[u]] += graph.capacity(e);
+                changes[ranks[v]] -= graph.capacity(e);
+            }
+        }
+    }
+
+    U best{0};
+    U capacity{0};
+    for (T k{0}; k < ranks[graph.sink]; ++k)
+    {
+        capacity += changes[k];
+        if (k == ranks[graph.source] || (k > ranks[graph.source] && capacity < best))
+            best = capacity;
+    }
+    return best;
+}
+
+#endif // MIN_CUT_H
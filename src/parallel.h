@@ -0,0 +1,140 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+// Number of threads to use when the user did not ask for a specific count.
+inline unsigned defaultThreadCount()
+{
+    unsigned count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+// Adds value to an atomic. Works for floating point types as well, which do
+// not have fetch_add before C++20.
+template <typename U>
+inline void atomicAdd(std::atomic<U> &target, const U value)
+{
+    U current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed))
+    {
+    }
+}
+
+// First index of the part of [0, size) that thread id owns when the range is
+// split evenly between threadCount threads.
+inline std::size_t partitionBegin(std::size_t size, unsigned id, unsigned threadCount)
+{
+    return size * id / threadCount;
+}
+
+// Calls f(id) for every id in [0, threadCount), each on its own thread. The
+// calling thread runs id 0. Returns when all calls are done.
+template <typename F>
+void runInParallel(unsigned threadCount, F f)
+{
+    std::vector<std::thread> workers;
+    for (unsigned id{1}; id < threadCount; ++id)
+    {
+        workers.emplace_back(f, id);
+    }
+    f(0);
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+// Stable counting sort of the items [0, size) by key(i), which is below
+// keyCount. Calls place(i, position) with the sorted position of every item
+// and returns the offsets of the keys: items with key k get the positions
+// [offsets[k], offsets[k + 1]).
+//
+// Every thread counts the keys of a contiguous range of items and places
+// them after the same keys of the ranges before it. Each thread keeps a
+// count per key, so fewer threads are used when there are few items per key.
+template <typename T, typename Key, typename Place>
+std::vector<T> countingSort(std::size_t size, std::size_t keyCount, Key key, Place place, unsigned threadCount)
+{
+    threadCount = std::max<std::size_t>(1, std::min<std::size_t>(threadCount, size / (keyCount + 1)));
+
+    // counts[id][k] becomes the first position of thread id's items with key k
+    std::vector<std::vector<T>> counts(threadCount);
+    auto count = [&](unsigned id)
+    {
+        counts[id].assign(keyCount, 0);
+        std::size_t end = partitionBegin(size, id + 1, threadCount);
+        for (std::size_t i = partitionBegin(size, id, threadCount); i < end; ++i)
+        {
+            counts[id][key(i)]++;
+        }
+    };
+    runInParallel(threadCount, count);
+
+    std::vector<T> offsets(keyCount + 1);
+    T position{0};
+    for (std::size_t k{0}; k < keyCount; ++k)
+    {
+        offsets[k] = position;
+        for (unsigned id{0}; id < threadCount; ++id)
+        {
+            T count = counts[id][k];
+            counts[id][k] = position;
+            position += count;
+        }
+    }
+    offsets[keyCount] = position;
+
+    auto distribute = [&](unsigned id)
+    {
+        std::size_t end = partitionBegin(size, id + 1, threadCount);
+        for (std::size_t i = partitionBegin(size, id, threadCount); i < end; ++i)
+        {
+            place(i, counts[id][key(i)]++);
+        }
+    };
+    runInParallel(threadCount, distribute);
+
+    return offsets;
+}
+
+// Reusable barrier for a fixed number of threads.
+class Barrier
+{
+public:
+    explicit Barrier(unsigned count) : count(count) {}
+
+    // Blocks until all threads have called wait().
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        unsigned arrivedGeneration = generation;
+
+        if (++arrived == count)
+        {
+            arrived = 0;
+            generation++;
+            condition.notify_all();
+        }
+        else
+        {
+            condition.wait(lock, [&]
+                           { return arrivedGeneration != generation; });
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    const unsigned count;
+    unsigned arrived{0};
+    unsigned generation{0};
+};
+
+#endif // PARALLEL_H
@@ -0,0 +1,111 @@
+#ifndef PARAMETRIC_H
+#define PARAMETRIC_H
+
+#include "graph.h"
+#include "push_relabel.h"
+#include "min_cut.h"
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+// Parametric max flow in the setting of Gallo, Grigoriadis and Tarjan. At
+// parameter lambda, an arc from the source with capacity c in the graph has
+// capacity max(c + lambda, 0), and an arc into the sink has capacity
+// max(c - lambda, 0). Other arcs, including an arc from the source to the
+// sink, keep their capacity.
+//
+// As lambda increases, source arcs only grow and sink arcs only shrink. The
+// heights of push-relabel then stay valid from one lambda to the next: the
+// added source capacity is saturated, and flow above the new capacity of a
+// sink arc is left as excess at its tail. Push-relabel continues from the
+// previous preflow, and heights never decrease, so all values together take
+// about the time of one solve. The minimum cuts found are nested.
+
+template <typename U>
+struct ParametricResult
+{
+    U lambda;
+    U maxflow;
+
+    // Source side of a minimum cut
+    std::vector<bool> sourceSide;
+};
+
+// Returns the max flow value and a minimum cut at every lambda, in
+// increasing order of lambda. For integer capacities, throws
+// std::invalid_argument if a lambda could make a capacity, flow or excess
+// overflow U.
+template <typename T, typename U>
+std::vector<ParametricResult<U>> solveParametric(const Graph<T, U> &graph, std::vector<U> lambdas)
+{
+    std::sort(lambdas.begin(), lambdas.end());
+    std::vector<ParametricResult<U>> results;
+    if (lambdas.empty())
+        return results;
+
+    std::vector<T> sourceArcs;
+    for (T e = graph.offsets[graph.source]; e < graph.offsets[graph.source + 1]; ++e)
+    {
+        if (graph.heads[e] != graph.sink)
+            sourceArcs.push_back(e);
+    }
+
+    std::vector<T> sinkArcs;
+    for (T e = graph.offsets[graph.sink]; e < graph.offsets[graph.sink + 1]; ++e)
+    {
+        if (graph.heads[e] != graph.source)
+            sinkArcs.push_back(graph.antiParallel[e]);
+    }
+
+    // No capacity, flow or excess at lambda exceeds the sum of the
+    // capacities with |lambda| added to every terminal arc
+    if constexpr (std::is_integral_v<U>)
+    {
+        const unsigned long long largest = std::numeric_limits<U>::max();
+        unsigned long long sum{0};
+        for (U capacity : graph.capacities)
+            sum += std::min<unsigned long long>(capacity, largest + 1 - sum);
+        const unsigned long long terminalArcCount = sourceArcs.size() + sinkArcs.size();
+
+        for (U lambda : lambdas)
+        {
+            unsigned long long magnitude = lambda < 0 ? 0ULL - static_cast<unsigned long long>(lambda) : lambda;
+            if (sum > largest || (terminalArcCount > 0 && magnitude > (largest - sum) / terminalArcCount))
+            {
+                throw std::invalid_argument("Lambda " + std::to_string(lambda) + " makes the capacities overflow");
+            }
+        }
+    }
+
+    auto capacitiesAt = [&](U lambda)
+    {
+        std::vector<CapacityChange<T, U>> changes;
+        changes.reserve(sourceArcs.size() + sinkArcs.size());
+        for (T e : sourceArcs)
+            changes.push_back({e, std::max(graph.capacities[e] + lambda, U(0))});
+        for (T e : sinkArcs)
+            changes.push_back({e, std::max(graph.capacities[e] - lambda, U(0))});
+        return changes;
+    };
+
+    // The first lambda is solved from scratch on a copy of the graph
+    Graph<T, U> parametric = graph;
+    for (const auto &change : capacitiesAt(lambdas[0]))
+        parametric.capacities[change.arc] = change.capacity;
+
+    PushRelabel<T, U> pushRelabel(parametric);
+    U maxflow = pushRelabel.findMaxFlow();
+
+    for (std::size_t i{0}; i < lambdas.size(); ++i)
+    {
+        if (i > 0)
+            maxflow = pushRelabel.updateCapacities(capacitiesAt(lambdas[i]));
+        results.push_back({lambdas[i], maxflow, findMinCut(parametric, pushRelabel.getResidualCapacities())});
+    }
+    return results;
+}
+
+#endif // PARAMETRIC_H
@@ -0,0 +1,402 @@
+#ifndef PSEUDOFLOW_H
+#define PSEUDOFLOW_H
+
+#include <vector>
+#include <algorithm>
+#include "graph.h"
+
+// Hochbaum's pseudoflow algorithm, highest label variant (HPF).
+//
+// All arcs leaving the source and entering the sink are saturated up front.
+// The other vertices then have excess (strong) or deficit (weak), and are
+// organized in a forest of normalized trees where only a root may carry
+// excess or deficit. Repeatedly, the strong root of highest label looks for
+// a residual arc from its tree to a vertex one label lower. If one is found
+// the two trees are merged and the excess is pushed along the new tree path;
+// a tree arc that can not take all of it is split off. Otherwise the labels
+// of the tree are raised. When no vertex has the label just below a strong
+// root, the whole tree is lifted to label V: it is on the source side of the
+// minimum cut.
+//
+// After findMaxFlow() the residual graph holds a pseudoflow, not a flow. The
+// minimum cut is read from the labels by minCut().
+template <typename T, typename U>
+class Pseudoflow
+{
+public:
+    Pseudoflow(const Graph<T, U> &graph) : graph(graph), none(graph.V) {}
+
+    U findMaxFlow()
+    {
+        initialize();
+
+        T strongRoot;
+        while ((strongRoot = nextStrongRoot()) != none)
+        {
+            processRoot(strongRoot);
+        }
+
+        // All arcs out of the source side are saturated and all arcs into it
+        // are empty, so the flow across the cut is the flow into the sink
+        // minus the deficits on the sink side.
+        U maxflow = sinkInflow;
+        for (T v{0}; v < graph.V; ++v)
+        {
+            if (labels[v] < graph.V && v != graph.source && v != graph.sink)
+                maxflow += excessflow[v];
+        }
+        return maxflow;
+    }
+
+    // Source side of a minimum cut: the source and all lifted vertices.
+    std::vector<bool> minCut() const
+    {
+        std::vector<bool> sourceSide(graph.V);
+        for (T v{0}; v < graph.V; ++v)
+        {
+            sourceSide[v] = labels[v] == graph.V;
+        }
+        sourceSide[graph.sink] = false;
+        return sourceSide;
+    }
+
+    // Residual capacities left by the last solve
+    const std::vector<U> &getResidualCapacities() const
+    {
+        return capacities;
+    }
+
+private:
+    const Graph<T, U> &graph;
+
+    // Residual capacities of the current solve
+    std::vector<U> capacities;
+
+    // Marks the absence of a vertex, and of an arc.
+    const T none;
+    T noArc{0};
+
+    std::vector<T> labels;
+    std::vector<T> labelCount;
+    std::vector<U> excessflow;
+    U sinkInflow{0};
+
+    // Normalized trees. Children of a vertex form a doubly linked list.
+    std::vector<T> parents;
+    std::vector<T> arcToParent;
+    std::vector<T> firstChild;
+    std::vector<T> nextSibling;
+    std::vector<T> prevSibling;
+
+    // Next child to visit when a tree is searched, and next arc to scan for
+    // a merger.
+    std::vector<T> nextScan;
+    std::vector<T> nextArc;
+
+    // Strong roots, in buckets by label.
+    std::vector<T> strongRoots;
+    std::vector<T> nextRoot;
+    T highestStrongLabel{1};
+
+    void initialize()
+    {
+        capacities.assign(graph.capacities.begin(), graph.capacities.end());
+        noArc = graph.heads.size();
+        labels.assign(graph.V, 0);
+        labelCount.assign(graph.V + 1, 0);
+        excessflow.assign(graph.V, 0);
+        parents.assign(graph.V, none);
+        arcToParent.assign(graph.V, noArc);
+        firstChild.assign(graph.V, none);
+        nextSibling.assign(graph.V, none);
+        prevSibling.assign(graph.V, none);
+        nextScan.assign(graph.V, none);
+        nextArc.assign(graph.offsets.begin(), graph.offsets.end() - 1);
+        strongRoots.assign(graph.V + 1, none);
+        nextRoot.assign(graph.V, none);
+        highestStrongLabel = 1;
+        sinkInflow = 0;
+
+        // Saturate the arcs leaving the source
+        for (T e = graph.offsets[graph.source]; e < graph.offsets[graph.source + 1]; ++e)
+        {
+            T v = graph.heads[e];
+            if (v == graph.sink)
+                sinkInflow += capacities[e];
+            else
+                excessflow[v] += capacities[e];
+            saturate(e);
+        }
+
+        // Saturate the arcs entering the sink
+        for (T e = graph.offsets[graph.sink]; e < graph.offsets[graph.sink + 1]; ++e)
+        {
+            T v = graph.heads[e];
+            T in = graph.antiParallel[e];
+            sinkInflow += capacities[in];
+            excessflow[v] -= capacities[in];
+            saturate(in);
+        }
+
+        excessflow[graph.source] = 0;
+        excessflow[graph.sink] = 0;
+
+        for (T v{0}; v < graph.V; ++v)
+        {
+            if (v == graph.source || v == graph.sink)
+                continue;
+
+            if (excessflow[v] > 0)
+            {
+                labels[v] = 1;
+                addToStrongBucket(v);
+            }
+            labelCount[labels[v]]++;
+        }
+
+        labels[graph.source] = graph.V;
+        labels[graph.sink] = 0;
+    }
+
+    void saturate(T e)
+    {
+        capacities[graph.antiParallel[e]] += capacities[e];
+        capacities[e] = 0;
+    }
+
+    void addToStrongBucket(T v)
+    {
+        nextRoot[v] = strongRoots[labels[v]];
+        strongRoots[labels[v]] = v;
+    }
+
+    T popStrongBucket(T label)
+    {
+        T v = strongRoots[label];
+        strongRoots[label] = nextRoot[v];
+        nextRoot[v] = none;
+        return v;
+    }
+
+    void addRelationship(T parent, T child, T arc)
+    {
+        parents[child] = parent;
+        arcToParent[child] = arc;
+        prevSibling[child] = none;
+        nextSibling[child] = firstChild[parent];
+        if (firstChild[parent] != none)
+            prevSibling[firstChild[parent]] = child;
+        firstChild[parent] = child;
+    }
+
+    void breakRelationship(T parent, T child)
+    {
+        if (prevSibling[child] != none)
+            nextSibling[prevSibling[child]] = nextSibling[child];
+        else
+            firstChild[parent] = nextSibling[child];
+
+        if (nextSibling[child] != none)
+            prevSibling[nextSibling[child]] = prevSibling[child];
+
+        parents[child] = none;
+        nextSibling[child] = none;
+        prevSibling[child] = none;
+    }
+
+    // Returns the strong root to process next, or none when done. Strong
+    // roots above a label that no vertex has are lifted instead.
+    T nextStrongRoot()
+    {
+        for (T label = highestStrongLabel; label > 0; --label)
+        {
+            if (strongRoots[label] == none)
+                continue;
+
+            highestStrongLabel = label;
+            if (labelCount[label - 1] > 0)
+                return popStrongBucket(label);
+
+            // Gap: these trees can not reach a weak vertex
+            while (strongRoots[label] != none)
+            {
+                liftAll(popStrongBucket(label));
+            }
+        }
+
+        if (strongRoots[0] == none)
+            return none;
+
+        // Weak vertices that received enough excess to become strong roots
+        while (strongRoots[0] != none)
+        {
+            T v = popStrongBucket(0);
+            labelCount[0]--;
+            labels[v] = 1;
+            labelCount[1]++;
+            addToStrongBucket(v);
+        }
+
+        highestStrongLabel = 1;
+        return popStrongBucket(1);
+    }
+
+    // Lifts every vertex of the tree to label V.
+    void liftAll(T root)
+    {
+        T current = root;
+        nextScan[current] = firstChild[current];
+        labelCount[labels[current]]--;
+        labels[current] = graph.V;
+
+        for (; current != none; current = parents[current])
+        {
+            while (nextScan[current] != none)
+            {
+                T child = nextScan[current];
+                nextScan[current] = nextSibling[child];
+                current = child;
+                nextScan[current] = firstChild[current];
+                labelCount[labels[current]]--;
+                labels[current] = graph.V;
+            }
+        }
+    }
+
+    // Returns a residual arc from v to a vertex with the label just below
+    // the highest strong label, or noArc.
+    T findWeakNode(T v)
+    {
+        for (T &e = nextArc[v]; e < graph.offsets[v + 1]; ++e)
+        {
+            if (capacities[e] > 0 && labels[graph.heads[e]] + 1 == highestStrongLabel)
+                return e;
+        }
+        return noArc;
+    }
+
+    // Skips the children of v with a different label than v. If none is
+    // left, v is relabeled.
+    void checkChildren(T v)
+    {
+        for (; nextScan[v] != none; nextScan[v] = nextSibling[nextScan[v]])
+        {
+            if (labels[nextScan[v]] == labels[v])
+                return;
+        }
+
+        labelCount[labels[v]]--;
+        labels[v]++;
+        labelCount[labels[v]]++;
+        nextArc[v] = graph.offsets[v];
+    }
+
+    // Searches the tree of strongRoot depth first for a merger arc, visiting
+    // only vertices at the root's label. Vertices without a merger arc are
+    // relabeled after their children.
+    void processRoot(T strongRoot)
+    {
+        T strongNode = strongRoot;
+        nextScan[strongRoot] = firstChild[strongRoot];
+
+        T arc = findWeakNode(strongRoot);
+        if (arc != noArc)
+        {
+            merge(graph.heads[arc], strongRoot, arc);
+            pushExcess(strongRoot);
+            return;
+        }
+        checkChildren(strongRoot);
+
+        while (strongNode != none)
+        {
+            while (nextScan[strongNode] != none)
+            {
+                T child = nextScan[strongNode];
+                nextScan[strongNode] = nextSibling[child];
+                strongNode = child;
+                nextScan[strongNode] = firstChild[strongNode];
+
+                arc = findWeakNode(strongNode);
+                if (arc != noArc)
+                {
+                    merge(graph.heads[arc], strongNode, arc);
+                    pushExcess(strongRoot);
+                    return;
+                }
+                checkChildren(strongNode);
+            }
+
+            strongNode = parents[strongNode];
+            if (strongNode != none)
+                checkChildren(strongNode);
+        }
+
+        addToStrongBucket(strongRoot);
+        highestStrongLabel++;
+    }
+
+    // Makes strongNode the root of its tree and hangs the tree below
+    // weakNode by the arc from strongNode to weakNode.
+    void merge(T weakNode, T strongNode, T arc)
+    {
+        T current = strongNode;
+        T newParent = weakNode;
+        T newArc = arc;
+
+        while (parents[current] != none)
+        {
+            T oldParent = parents[current];
+            T oldArc = arcToParent[current];
+            breakRelationship(oldParent, current);
+            addRelationship(newParent, current, newArc);
+            newParent = current;
+            current = oldParent;
+            newArc = graph.antiParallel[oldArc];
+        }
+        addRelationship(newParent, current, newArc);
+    }
+
+    // Pushes the excess of the former strong root towards the root of the
+    // merged tree. Where an arc can not take all the excess, it is split off
+    // and the vertex below becomes a strong root.
+    void pushExcess(T strongRoot)
+    {
+        T current = strongRoot;
+        U previousExcess{1};
+
+        while (excessflow[current] > 0 && parents[current] != none)
+        {
+            T parent = parents[current];
+            T arc = arcToParent[current];
+            previousExcess = excessflow[parent];
+
+            if (capacities[arc] >= excessflow[current])
+            {
+                capacities[arc] -= excessflow[current];
+                capacities[graph.antiParallel[arc]] += excessflow[current];
+                excessflow[parent] += excessflow[current];
+                excessflow[current] = 0;
+            }
+            else
+            {
+                excessflow[parent] += capacities[arc];
+                excessflow[current] -= capacities[arc];
+                saturate(arc);
+                breakRelationship(parent, current);
+
+                // The reverse arc is residual now, so the parent must scan it again
+                nextArc[parent] = std::min(nextArc[parent], graph.antiParallel[arc]);
+                addToStrongBucket(current);
+            }
+
+            current = parent;
+        }
+
+        // The root of the merged tree turned strong
+        if (excessflow[current] > 0 && previousExcess <= 0)
+            addToStrongBucket(current);
+    }
+};
+
+#endif // PSEUDOFLOW_H
@@ -2,6 +2,10 @@
 #define PUSH_RELABEL_H
 
 #include "graph.h"
+#include "stats.h"
+#include "arc_scan.h"
+#include "min_cut.h"
+#include "cancellation.h"
 #include <stdio.h>
 #include <vector>
 #include <iostream>
@@ -9,7 +13,9 @@
 #include <cassert>
 #include <memory>
 #include <algorithm>
-#include <cassert>
+#include <deque>
+#include <string>
+#include <stdexcept>
 
 template <typename T>
 struct RTFvertex
@@ -18,26 +24,41 @@ struct RTFvertex
     std::shared_ptr<RTFvertex> next;
 };
 
+// New capacity of an arc, given by its index in the graph
+template <typename T, typename U>
+struct CapacityChange
+{
+    T arc;
+    U capacity;
+};
+
 template <typename T, typename U>
 class PushRelabel
 {
 public:
     // Constructor for the RelabelToFront class, initializes graph
-    PushRelabel(Graph<T, U> &graph) : graph(graph) {}
+    PushRelabel(const Graph<T, U> &graph) : graph(graph) {}
 
     // Main function to compute the maximum flow using the relabel-to-front algorithm
     U findMaxFlow()
     {
         auto Lhead = initializePreflow();
-        currents.resize(graph.V, 0);
+        currents.assign(graph.offsets.begin(), graph.offsets.end() - 1);
         std::shared_ptr<RTFvertex<T>> u = Lhead;
         std::shared_ptr<RTFvertex<T>> uprev = nullptr;
         int oldHeight;
 
+        stopped = false;
         while (u != nullptr)
         {
+            if (cancellation && cancellation->poll())
+            {
+                stopped = true;
+                break;
+            }
+
             oldHeight = heights[u->index];
-            discharge(u);
+            discharge(u->index);
 
             // If u was relabelled during discharge: Move u to front of L
             if (heights[u->index] > oldHeight)
@@ -54,46 +75,223 @@ public:
             u = u->next;
         }
 
+        solved = !stopped;
+        return excessflow[graph.sink];
+    }
+
+    // Solves as findMaxFlow() until the token expires. The lower bound is
+    // the excess of the sink, and the upper bound the best cut between the
+    // heights.
+    FlowBounds<U> findFlowBounds(CancellationToken &token)
+    {
+        cancellation = &token;
+        U flow = findMaxFlow();
+        cancellation = nullptr;
+        if (!stopped)
+            return {flow, flow};
+
+        // Heights are below 2V, and ranked from the top
+        std::vector<T> ranks(graph.V);
+        for (T v{0}; v < graph.V; ++v)
+            ranks[v] = std::max<T>(0, 2 * graph.V - 1 - heights[v]);
+        return {flow, findBestThresholdCut<U>(graph, ranks, 2 * graph.V)};
+    }
+
+    // Changes the capacities of some arcs after findMaxFlow(), and returns the
+    // max flow value with the new capacities. The flow and the heights of the
+    // last solve are kept, as in dynamic graph cuts:
+    // 1. Flow above the new capacity of an arc is taken back, which leaves
+    //    an excess at its tail and a deficit at its head.
+    // 2. A deficit is cancelled along flow carrying paths to a terminal or
+    //    to a vertex with excess.
+    // 3. Heights made invalid by arcs that got residual capacity are lowered,
+    //    and arcs from the source are saturated instead.
+    // 4. The vertices with excess are discharged in FIFO order.
+    // The work depends on the part of the graph the changes reach, not on
+    // its size. The graph is not changed; the new capacities only apply to
+    // this solver, until findMaxFlow() is called again.
+    U updateCapacities(const std::vector<CapacityChange<T, U>> &changes)
+    {
+        if (!solved)
+        {
+            throw std::logic_error("Capacities can only be updated after findMaxFlow().");
+        }
+        if (visited.size() != static_cast<std::size_t>(graph.V))
+        {
+            visited.assign(graph.V, 0);
+            queued.assign(graph.V, false);
+        }
+
+        // Tails of the arcs that got residual capacity, whose heights may be invalid
+        std::vector<T> unchecked;
+        std::vector<T> deficits;
+
+        for (const auto &change : changes)
+        {
+            T e = change.arc;
+            if (static_cast<std::size_t>(e) >= graph.heads.size() || change.capacity < 0)
+            {
+                throw std::logic_error("Invalid capacity change of arc " + std::to_string(e) + ".");
+            }
+
+            T reverse = graph.antiParallel[e];
+            T tail = graph.heads[reverse];
+            U increase = change.capacity - arcCapacities[e];
+            capacities[e] += increase;
+            arcCapacities[e] = change.capacity;
+
+            if (capacities[e] < 0)
+            {
+                U overflow = -capacities[e];
+                capacities[e] = 0;
+                capacities[reverse] -= overflow;
+                excessflow[tail] += overflow;
+                excessflow[graph.heads[e]] -= overflow;
+                deficits.push_back(graph.heads[e]);
+            }
+            else if (increase > 0)
+            {
+                unchecked.push_back(tail);
+            }
+            if (excessflow[tail] > 0)
+                activate(tail);
+        }
+
+        for (T v : deficits)
+            cancelDeficit(v, unchecked);
+
+        repairHeights(unchecked);
+
+        while (!active.empty())
+        {
+            T u = active.front();
+            active.pop_front();
+            queued[u] = false;
+            discharge(u);
+
+            for (T e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e)
+                activate(graph.heads[e]);
+        }
+
         return excessflow[graph.sink];
     }
 
+    const Stats &getStats() const
+    {
+        return stats;
+    }
+
+    // Residual capacities left by the last solve
+    const std::vector<U> &getResidualCapacities() const
+    {
+        return capacities;
+    }
+
 private:
-    Graph<T, U> &graph;
+    const Graph<T, U> &graph;
+
+    // Residual capacities of the current solve
+    std::vector<U> capacities;
+    Stats stats;
 
     std::vector<int> heightCount;
     std::vector<int> heights;
     std::vector<U> excessflow;
     std::vector<T> currents;
 
+    // Capacities of the arcs, including the changes since the last solve
+    std::vector<U> arcCapacities;
+    bool solved{false};
+
+    // Token checked before every discharge, if set
+    CancellationToken *cancellation{nullptr};
+    bool stopped{false};
+
+    // Vertices with excess left to discharge after capacity changes
+    std::deque<T> active;
+    std::vector<bool> queued;
+
+    // Search state of cancelDeficit(). A vertex is visited if it has the current stamp.
+    std::vector<unsigned> visited;
+    unsigned stamp{0};
+    std::vector<T> parentArcs;
+    std::vector<T> searchQueue;
+
+    // Vertices below the height of the source, in a doubly linked list per
+    // height, so that a gap only visits the vertices above it. V ends a
+    // list. No list above maxBucket has a vertex.
+    std::vector<T> bucketFirst;
+    std::vector<T> bucketNext;
+    std::vector<T> bucketPrev;
+    int maxBucket{0};
+
+    void link(T v, int height)
+    {
+        bucketPrev[v] = graph.V;
+        bucketNext[v] = bucketFirst[height];
+        if (bucketFirst[height] != graph.V)
+            bucketPrev[bucketFirst[height]] = v;
+        bucketFirst[height] = v;
+        maxBucket = std::max(maxBucket, height);
+    }
+
+    void unlink(T v, int height)
+    {
+        if (bucketPrev[v] != graph.V)
+            bucketNext[bucketPrev[v]] = bucketNext[v];
+        else
+            bucketFirst[height] = bucketNext[v];
+        if (bucketNext[v] != graph.V)
+            bucketPrev[bucketNext[v]] = bucketPrev[v];
+    }
+
+    // Moves v to the given height, in the counts and the lists
+    void setHeight(T v, int height)
+    {
+        int old = heights[v];
+        heightCount[old]--;
+        heightCount[height]++;
+        heights[v] = height;
+        if (old < graph.V)
+            unlink(v, old);
+        if (height < graph.V)
+            link(v, height);
+    }
+
     // Initialize preflow operation, also sets up initial heights and list L
     std::shared_ptr<RTFvertex<T>> initializePreflow()
     {
 
-        // Initialize heights and excess flow
-        heights.resize(graph.V, 0);
-        excessflow.resize(graph.V, 0);
+        // Initialize residual capacities, heights and excess flow
+        capacities.assign(graph.capacities.begin(), graph.capacities.end());
+        arcCapacities.assign(graph.capacities.begin(), graph.capacities.end());
+        heights.assign(graph.V, 0);
+        excessflow.assign(graph.V, 0);
 
         // Set source height to number of vertices
         heights[graph.source] = graph.V;
 
         // Set up gap heuristics.
-        heightCount.resize(2 * graph.V, 0);
+        heightCount.assign(2 * graph.V, 0);
         heightCount[graph.V] = 1;
         heightCount[0] = graph.V - 1;
+        bucketFirst.assign(graph.V, graph.V);
+        bucketNext.resize(graph.V);
+        bucketPrev.resize(graph.V);
+        maxBucket = 0;
+        for (T v{0}; v < graph.V; ++v)
+        {
+            if (v != graph.source)
+                link(v, 0);
+        }
 
         // Initialize excess flow for edges originating from source
-        for (auto &e : graph.adj_list[graph.source])
+        for (T e = graph.offsets[graph.source]; e < graph.offsets[graph.source + 1]; ++e)
         {
-            excessflow[e->v] += e->capacity;
-            excessflow[graph.source] -= e->capacity;
-
-            // Convert the weak_ptr to a shared_ptr before accessing
-            std::shared_ptr<Edge<T, U>> antiParallelEdge = e->antiParallel.lock();
-            assert(antiParallelEdge && "Failed to lock antiParallel weak_ptr");
-
-            antiParallelEdge->capacity += e->capacity;
-
-            e->capacity = 0;
+            excessflow[graph.heads[e]] += capacities[e];
+            excessflow[graph.source] -= capacities[e];
+            capacities[graph.antiParallel[e]] += capacities[e];
+            capacities[e] = 0;
         }
 
         // Set up list L containing all vertices except source and sink
@@ -121,80 +319,199 @@ private:
     }
 
     // Relabel operation: increases height of overflowing vertex
-    void relabel(std::shared_ptr<RTFvertex<T>> u)
+    void relabel(T u)
     {
-        // Find minimum height of neighbors
-        int minHeight = INT_MAX;
-        for (auto e : graph.adj_list[u->index])
-        {
-            if (e->capacity > 0)
-                minHeight = std::min(minHeight, heights[e->v]);
-        }
-
-        int k = heights[u->index];
-        heights[u->index] = minHeight + 1;
+        ++stats.relabels;
+        stats.arcsScanned += graph.offsets[u + 1] - graph.offsets[u];
 
-        // Perform the gap relabeling
+        // Find minimum height of neighbors
+        int minHeight = ArcScan::minResidualHeight(graph.heads.data(), capacities.data(), heights.data(),
+                                                   graph.offsets[u], graph.offsets[u + 1], INT_MAX);
 
-        // Update heightCount
-        heightCount[k]--;
-        heightCount[minHeight + 1]++;
+        int k = heights[u];
+        setHeight(u, minHeight + 1);
 
-        // If a gap is created, update heights of all vertices
-        if (heightCount[k] == 0)
+        // If a gap is created, lift the vertices above it to the height of
+        // the source. A gap at the height of the source or above lifts no
+        // vertex.
+        if (heightCount[k] == 0 && k < graph.V)
         {
-            for (int i = 0; i < graph.V; ++i)
+            ++stats.gaps;
+            for (int h = k + 1; h <= maxBucket; ++h)
             {
-                if (heights[i] > k && heights[i] < graph.V)
+                while (bucketFirst[h] != graph.V)
                 {
-                    heights[i] = graph.V;
-                    heightCount[graph.V]++;
-                    heightCount[heights[i]]--;
+                    ++stats.gapVertices;
+                    setHeight(bucketFirst[h], graph.V);
                 }
             }
+            maxBucket = k - 1;
         }
     }
 
-    // Push operation: push flow from vertex u to its current neighbor
-    void push(std::shared_ptr<RTFvertex<T>> u, T current)
+    // Push operation: push flow from vertex u along its current arc
+    void push(T u, T current)
     {
-        auto delta = std::min(graph.adj_list[u->index][current]->capacity,
-                              excessflow[u->index]);
-        excessflow[u->index] -= delta;
-        excessflow[graph.adj_list[u->index][current]->v] += delta;
-        graph.adj_list[u->index][current]->capacity -= delta;
-
-        // Convert the weak_ptr to a shared_ptr before accessing
-        std::shared_ptr<Edge<T, U>> antiParallelEdge = graph.adj_list[u->index][current]->antiParallel.lock();
-        assert(antiParallelEdge && "Failed to lock antiParallel weak_ptr");
-        antiParallelEdge->capacity += delta;
+        auto delta = std::min(capacities[current], excessflow[u]);
+        if (delta == capacities[current])
+            ++stats.saturatingPushes;
+        else
+            ++stats.nonSaturatingPushes;
+        excessflow[u] -= delta;
+        excessflow[graph.heads[current]] += delta;
+        capacities[current] -= delta;
+        capacities[graph.antiParallel[current]] += delta;
     }
 
     // Discharge operation: push flow out of vertex until it's no longer overflowing
-    void discharge(std::shared_ptr<RTFvertex<T>> u)
+    void discharge(T u)
     {
-        T current = currents[u->index];
+        T current = currents[u];
 
-        while (excessflow[u->index] > 0)
+        while (excessflow[u] > 0)
         {
-            if (current == (int)graph.adj_list[u->index].size())
+            if (current == graph.offsets[u + 1])
             {
                 relabel(u);
-                current = 0;
+                current = graph.offsets[u];
             }
-            else if (graph.adj_list[u->index][current]->capacity > 0 and
-                     heights[u->index] == heights[graph.adj_list[u->index][current]->v] + 1)
+            else if (capacities[current] > 0 and
+                     heights[u] == heights[graph.heads[current]] + 1)
             {
+                ++stats.arcsScanned;
                 push(u, current);
             }
             else
             {
+                ++stats.arcsScanned;
                 current++;
             }
 
-            currents[u->index] = current;
+            currents[u] = current;
+        }
+    }
+
+    // Queues v for discharging if it has excess and is not queued yet
+    void activate(T v)
+    {
+        if (excessflow[v] > 0 && v != graph.source && v != graph.sink && !queued[v])
+        {
+            queued[v] = true;
+            active.push_back(v);
+        }
+    }
+
+    // Takes back the flow into v that it can not pass on. Every path found
+    // by a BFS along arcs with flow out of v, to a terminal or a vertex with
+    // excess, has its flow reduced until v has no deficit. Such a path exists
+    // as long as v has a deficit, since the flow out of v has to end
+    // somewhere. The tails of the arcs on the paths are added to unchecked.
+    void cancelDeficit(T v, std::vector<T> &unchecked)
+    {
+        parentArcs.resize(graph.V);
+        while (excessflow[v] < 0 && v != graph.source && v != graph.sink)
+        {
+            stamp++;
+            visited[v] = stamp;
+            searchQueue.clear();
+            searchQueue.push_back(v);
+            T end = graph.V;
+
+            for (std::size_t i{0}; i < searchQueue.size() && end == graph.V; ++i)
+            {
+                T u = searchQueue[i];
+                for (T e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e)
+                {
+                    T w = graph.heads[e];
+                    if (visited[w] == stamp || capacities[e] >= arcCapacities[e])
+                        continue;
+
+                    visited[w] = stamp;
+                    parentArcs[w] = e;
+                    if (w == graph.source || w == graph.sink || excessflow[w] > 0)
+                    {
+                        end = w;
+                        break;
+                    }
+                    searchQueue.push_back(w);
+                }
+            }
+
+            if (end == graph.V)
+            {
+                throw std::logic_error("No flow path to cancel a deficit of vertex " + std::to_string(v) + ".");
+            }
+
+            U amount = -excessflow[v];
+            if (end != graph.source && end != graph.sink)
+                amount = std::min(amount, excessflow[end]);
+            for (T w = end; w != v; w = graph.heads[graph.antiParallel[parentArcs[w]]])
+                amount = std::min(amount, arcCapacities[parentArcs[w]] - capacities[parentArcs[w]]);
+
+            for (T w = end; w != v; w = graph.heads[graph.antiParallel[parentArcs[w]]])
+            {
+                T e = parentArcs[w];
+                capacities[e] += amount;
+                capacities[graph.antiParallel[e]] -= amount;
+                unchecked.push_back(graph.heads[graph.antiParallel[e]]);
+            }
+            excessflow[v] += amount;
+            excessflow[end] -= amount;
+        }
+    }
+
+    // Restores the height invariant h(u) <= h(w) + 1 for every residual arc
+    // u->w, starting from the vertices in unchecked. A vertex is lowered to
+    // one above its lowest residual neighbour, which may in turn invalidate
+    // the arcs into it. The source keeps its height and saturates its
+    // arcs to lower vertices instead.
+    void repairHeights(std::vector<T> &unchecked)
+    {
+        while (!unchecked.empty())
+        {
+            T u = unchecked.back();
+            unchecked.pop_back();
+            currents[u] = graph.offsets[u];
+            if (u == graph.sink)
+                continue;
+
+            if (u == graph.source)
+            {
+                for (T e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e)
+                {
+                    T w = graph.heads[e];
+                    if (capacities[e] > 0 && heights[u] > heights[w] + 1)
+                    {
+                        excessflow[w] += capacities[e];
+                        excessflow[u] -= capacities[e];
+                        capacities[graph.antiParallel[e]] += capacities[e];
+                        capacities[e] = 0;
+                        activate(w);
+                        unchecked.push_back(w);
+                    }
+                }
+                continue;
+            }
+
+            int lowest = heights[u];
+            for (T e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e)
+            {
+                if (capacities[e] > 0)
+                    lowest = std::min(lowest, heights[graph.heads[e]] + 1);
+            }
+            if (lowest == heights[u])
+                continue;
+
+            setHeight(u, lowest);
+
+            for (T e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e)
+            {
+                T w = graph.heads[e];
+                if (capacities[graph.antiParallel[e]] > 0 && heights[w] > lowest)
+                    unchecked.push_back(w);
+            }
         }
     }
 };
 
-#endif // PUSH_RELABEL_H
\ No newline at end of file
+#endif // PUSH_RELABEL_H
@@ -0,0 +1,367 @@
+#ifndef PUSH_RELABEL_HIGHEST_LABEL_H
+#define PUSH_RELABEL_HIGHEST_LABEL_H
+
+#include "graph.h"
+#include "bfs.h"
+#include "arc_scan.h"
+#include "min_cut.h"
+#include "cancellation.h"
+#include <vector>
+#include <algorithm>
+
+// Push-relabel algorithm that always discharges an active vertex of maximum
+// height, in the style of Cherkassky and Goldberg's hi_pr.
+//
+// Phase one computes a maximum preflow. Vertices are kept in buckets by
+// height, so the highest active vertex is found without searching. Heights
+// are periodically set to the exact residual distance to the sink by a
+// reverse BFS (global relabeling), and when a bucket becomes empty every
+// vertex above it is lifted out of the buckets (gap heuristic).
+// Phase two returns the excess that can not reach the sink to the source. It
+// is only needed when a flow is wanted, not just its value or a minimum cut.
+template <typename T, typename U>
+class HighestLabelPushRelabel
+{
+public:
+    HighestLabelPushRelabel(const Graph<T, U> &graph, unsigned threadCount = 1) : graph(graph), none(graph.V), bfs(threadCount) {}
+
+    // Runs both phases. The residual graph holds a maximum flow afterwards.
+    U findMaxFlow()
+    {
+        findMaxPreflow();
+        convertToFlow();
+
+        return excessflow[graph.sink];
+    }
+
+    // Phase one: pushes excess towards the sink until no vertex with excess
+    // can reach it. Returns the max flow value. The residual graph holds a
+    // maximum preflow, which is enough to find a minimum cut with findMinCut().
+    U findMaxPreflow()
+    {
+        initializePreflow();
+        globalRelabel();
+        dischargeActive();
+
+        return excessflow[graph.sink];
+    }
+
+    // Phase two: pushes the excess left by findMaxPreflow() back to the
+    // source, turning the maximum preflow into a maximum flow.
+    void convertToFlow()
+    {
+        relabelTowardsSource();
+        dischargeActive();
+    }
+
+    // Runs phase one until the token expires, which is enough for the max
+    // flow value. The lower bound is the excess of the sink, and the upper
+    // bound the best cut between the heights.
+    FlowBounds<U> findFlowBounds(CancellationToken &token)
+    {
+        cancellation = &token;
+        stopped = false;
+        U flow = findMaxPreflow();
+        cancellation = nullptr;
+        if (!stopped)
+            return {flow, flow};
+
+        // Heights of phase one are at most V, and ranked from the top
+        std::vector<T> ranks(graph.V);
+        for (T v{0}; v < graph.V; ++v)
+            ranks[v] = graph.V - heights[v];
+        return {flow, findBestThresholdCut<U>(graph, ranks, graph.V + 1)};
+    }
+
+    // Residual capacities left by the last solve
+    const std::vector<U> &getResidualCapacities() const
+    {
+        return capacities;
+    }
+
+private:
+    // Work is measured as scanned arcs plus beta per relabel. A global
+    // relabeling is done once the work since the last one exceeds
+    // 2 * (alpha * V + E), as in hi_pr.
+    static constexpr long long alpha = 6;
+    static constexpr long long beta = 12;
+
+    const Graph<T, U> &graph;
+
+    // Residual capacities of the current solve
+    std::vector<U> capacities;
+
+    // Marks the end of a bucket list.
+    const T none;
+
+    std::vector<T> heights;
+    std::vector<U> excessflow;
+    std::vector<T> currents;
+
+    // Every vertex of height below deadHeight, except the source and the
+    // sink, is in the bucket of its height: in the active list if it has
+    // excess, otherwise in the inactive list. The lists are intrusive and
+    // share the links next and prev; only the inactive lists are doubly linked.
+    std::vector<T> firstActive;
+    std::vector<T> firstInactive;
+    std::vector<T> next;
+    std::vector<T> prev;
+
+    // Highest bucket that may have active vertices, and highest non-empty bucket.
+    T maxActive{0};
+    T maxHeight{0};
+
+    // Vertices at this height are done for the current phase.
+    T deadHeight{0};
+    bool gapHeuristic{true};
+    long long workSinceUpdate{0};
+
+    FrontierBFS<T> bfs;
+    std::vector<T> distances;
+
+    // Token checked before every discharge, if set
+    CancellationToken *cancellation{nullptr};
+    bool stopped{false};
+
+    void initializePreflow()
+    {
+        capacities.assign(graph.capacities.begin(), graph.capacities.end());
+        heights.assign(graph.V, 0);
+        excessflow.assign(graph.V, 0);
+        currents.assign(graph.offsets.begin(), graph.offsets.end() - 1);
+        firstActive.assign(2 * graph.V + 1, none);
+        firstInactive.assign(2 * graph.V + 1, none);
+        next.assign(graph.V, none);
+        prev.assign(graph.V, none);
+
+        heights[graph.source] = graph.V;
+        maxActive = 0;
+        maxHeight = 0;
+        deadHeight = graph.V;
+        gapHeuristic = true;
+        workSinceUpdate = 0;
+
+        // Saturate all edges leaving the source
+        for (T e = graph.offsets[graph.source]; e < graph.offsets[graph.source + 1]; ++e)
+        {
+            excessflow[graph.heads[e]] += capacities[e];
+            excessflow[graph.source] -= capacities[e];
+            capacities[graph.antiParallel[e]] += capacities[e];
+            capacities[e] = 0;
+        }
+    }
+
+    void addActive(T v)
+    {
+        T h = heights[v];
+        next[v] = firstActive[h];
+        firstActive[h] = v;
+        maxActive = std::max(maxActive, h);
+        maxHeight = std::max(maxHeight, h);
+    }
+
+    void addInactive(T v)
+    {
+        T h = heights[v];
+        next[v] = firstInactive[h];
+        prev[v] = none;
+        if (firstInactive[h] != none)
+            prev[firstInactive[h]] = v;
+        firstInactive[h] = v;
+        maxHeight = std::max(maxHeight, h);
+    }
+
+    void removeInactive(T v)
+    {
+        if (prev[v] != none)
+            next[prev[v]] = next[v];
+        else
+            firstInactive[heights[v]] = next[v];
+
+        if (next[v] != none)
+            prev[next[v]] = prev[v];
+    }
+
+    // Empties the buckets from height 0 up to maxHeight.
+    void clearBuckets()
+    {
+        std::fill(firstActive.begin(), firstActive.begin() + maxHeight + 1, none);
+        std::fill(firstInactive.begin(), firstInactive.begin() + maxHeight + 1, none);
+        maxActive = 0;
+        maxHeight = 0;
+    }
+
+    // Sets the heights to the residual distance to the given root by a reverse
+    // BFS, starting at rootHeight. Unreached vertices get deadHeight.
+    void reverseBFS(T root, T rootHeight, T excluded)
+    {
+        clearBuckets();
+        auto open = [this](T e)
+        {
+            return capacities[graph.antiParallel[e]] > 0;
+        };
+        bfs.search(graph, root, open, distances, nullptr, FrontierBFS<T>::none, excluded);
+
+        std::fill(heights.begin(), heights.end(), deadHeight);
+        heights[root] = rootHeight;
+        const auto &order = bfs.getOrder();
+        for (auto w = order.begin() + 1; w != order.end(); ++w)
+        {
+            heights[*w] = rootHeight + distances[*w];
+            currents[*w] = graph.offsets[*w];
+            if (excessflow[*w] > 0)
+                addActive(*w);
+            else
+                addInactive(*w);
+        }
+    }
+
+    // Global relabeling for phase one.
+    void globalRelabel()
+    {
+        reverseBFS(graph.sink, 0, graph.source);
+        heights[graph.source] = graph.V;
+        workSinceUpdate = 0;
+    }
+
+    // Sets up phase two: heights become V plus the residual distance to the
+    // source. Every vertex with excess can reach the source.
+    void relabelTowardsSource()
+    {
+        deadHeight = 2 * graph.V;
+        gapHeuristic = false;
+        reverseBFS(graph.source, graph.V, graph.sink);
+        heights[graph.sink] = 0;
+    }
+
+    // Discharges active vertices, highest first, until none are left.
+    void dischargeActive()
+    {
+        while (true)
+        {
+            while (firstActive[maxActive] == none)
+            {
+                if (maxActive == 0)
+                    return;
+                maxActive--;
+            }
+
+            if (cancellation && cancellation->poll())
+            {
+                stopped = true;
+                return;
+            }
+
+            T v = firstActive[maxActive];
+            firstActive[maxActive] = next[v];
+            discharge(v);
+
+            if (gapHeuristic && workSinceUpdate > 2 * (alpha * graph.V + (long long)graph.heads.size()))
+            {
+                globalRelabel();
+            }
+        }
+    }
+
+    // Pushes the excess of v along admissible arcs, relabeling v whenever it
+    // runs out of them, until v has no excess or is dead.
+    void discharge(T v)
+    {
+        while (true)
+        {
+            T h = heights[v];
+            T e = currents[v];
+            const T end = graph.offsets[v + 1];
+
+            for (; e < end; ++e)
+            {
+                if (capacities[e] > 0 && heights[graph.heads[e]] + 1 == h)
+                {
+                    push(v, e);
+                    if (excessflow[v] == 0)
+                        break;
+                }
+            }
+
+            if (e < end)
+            {
+                currents[v] = e;
+                addInactive(v);
+                return;
+            }
+
+            relabel(v);
+            if (heights[v] >= deadHeight)
+                return;
+        }
+    }
+
+    void push(T v, T e)
+    {
+        T w = graph.heads[e];
+        U delta = std::min(capacities[e], excessflow[v]);
+
+        // w becomes active
+        if (excessflow[w] == 0 && w != graph.sink && w != graph.source)
+        {
+            removeInactive(w);
+            addActive(w);
+        }
+
+        capacities[e] -= delta;
+        capacities[graph.antiParallel[e]] += delta;
+        excessflow[v] -= delta;
+        excessflow[w] += delta;
+    }
+
+    // Lifts v to one above its lowest residual neighbour. v is not in any bucket.
+    void relabel(T v)
+    {
+        T oldHeight = heights[v];
+        T minHeight = deadHeight;
+        T minArc = graph.offsets[v];
+        const T end = graph.offsets[v + 1];
+
+        workSinceUpdate += beta + (end - minArc);
+        T lowest = ArcScan::minResidualHeight(graph.heads.data(), capacities.data(), heights.data(), minArc, end, deadHeight);
+        if (lowest + 1 < deadHeight)
+        {
+            // The current arc becomes the first arc to the lowest neighbour
+            minHeight = lowest + 1;
+            minArc = ArcScan::findAdmissibleArc(graph.heads.data(), capacities.data(), heights.data(), minArc, end, lowest);
+        }
+
+        // v was the last vertex at its old height, so nothing above it can reach the sink
+        if (gapHeuristic && firstActive[oldHeight] == none && firstInactive[oldHeight] == none)
+        {
+            gap(oldHeight);
+            heights[v] = deadHeight;
+            return;
+        }
+
+        heights[v] = std::min(minHeight, deadHeight);
+        currents[v] = minArc;
+    }
+
+    // Removes all vertices above the empty bucket at height h from the buckets.
+    void gap(T h)
+    {
+        for (T b = h + 1; b <= maxHeight; ++b)
+        {
+            for (T v = firstInactive[b]; v != none; v = next[v])
+            {
+                heights[v] = deadHeight;
+            }
+            for (T v = firstActive[b]; v != none; v = next[v])
+            {
+                heights[v] = deadHeight;
+            }
+            firstInactive[b] = none;
+            firstActive[b] = none;
+        }
+        maxHeight = h;
+        maxActive = std::min(maxActive, h);
+    }
+};
+
+#endif // PUSH_RELABEL_HIGHEST_LABEL_H
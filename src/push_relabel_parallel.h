@@ -0,0 +1,328 @@
+#ifndef PUSH_RELABEL_PARALLEL_H
+#define PUSH_RELABEL_PARALLEL_H
+
+#include "graph.h"
+#include "parallel.h"
+#include "bfs.h"
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+// Synchronous parallel push-relabel (Baumstark, Blelloch and Shun).
+// Every round all active vertices are discharged in parallel against the
+// heights from the start of the round. Excess pushed to a vertex is collected
+// in an atomic and applied when the round ends. Of two active vertices
+// sharing an arc pair, only the one that wins may use the pair, so residual
+// capacities are never written concurrently. Heights are kept exact by a
+// global relabeling (reverse BFS from the sink), which also decides when
+// the algorithm is done.
+template <typename T, typename U>
+class ParallelPushRelabel
+{
+public:
+    ParallelPushRelabel(const Graph<T, U> &graph, unsigned threadCount = defaultThreadCount())
+        : graph(graph), threadCount(std::max(1u, threadCount)), barrier(this->threadCount), bfs(1) {}
+
+    U findMaxFlow()
+    {
+        initializePreflow();
+
+        std::vector<std::thread> workers;
+        for (unsigned id{1}; id < threadCount; ++id)
+        {
+            workers.emplace_back(&ParallelPushRelabel::run, this, id);
+        }
+        run(0);
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+
+        return excessflow[graph.sink] + addedExcess[graph.sink];
+    }
+
+    // Residual capacities left by the last solve
+    const std::vector<U> &getResidualCapacities() const
+    {
+        return capacities;
+    }
+
+private:
+    // Work is measured as scanned arcs plus relabelWork per relabel. As in
+    // hi_pr, a global relabeling is done once the work since the last one
+    // exceeds 2 * (alpha * V + E).
+    static constexpr long long relabelWork = 12;
+    static constexpr long long alpha = 6;
+
+    const Graph<T, U> &graph;
+
+    // Residual capacities of the current solve
+    std::vector<U> capacities;
+
+    const unsigned threadCount;
+    Barrier barrier;
+
+    // Heights at the start of the round, and heights computed during it.
+    std::vector<T> heights;
+    std::vector<T> newHeights;
+    std::vector<U> excessflow;
+    std::vector<std::atomic<U>> addedExcess;
+
+    // A vertex is claimed by the thread that stamps it with the current epoch.
+    std::vector<std::atomic<unsigned>> stamps;
+    unsigned epoch{0};
+
+    std::vector<T> active;
+    std::vector<std::vector<T>> discovered;
+    std::atomic<std::size_t> cursor{0};
+
+    std::atomic<long long> work{0};
+    long long workSinceUpdate{0};
+    bool globalUpdateNeeded{true};
+
+    FrontierBFS<T> bfs;
+
+    void initializePreflow()
+    {
+        capacities.assign(graph.capacities.begin(), graph.capacities.end());
+        heights.assign(graph.V, 0);
+        newHeights.assign(graph.V, 0);
+        excessflow.assign(graph.V, 0);
+        addedExcess = std::vector<std::atomic<U>>(graph.V);
+        stamps = std::vector<std::atomic<unsigned>>(graph.V);
+        discovered.assign(threadCount, {});
+        active.clear();
+        work = 0;
+        workSinceUpdate = 0;
+        globalUpdateNeeded = true;
+
+        // Saturate all edges leaving the source
+        for (T e = graph.offsets[graph.source]; e < graph.offsets[graph.source + 1]; ++e)
+        {
+            excessflow[graph.heads[e]] += capacities[e];
+            excessflow[graph.source] -= capacities[e];
+            capacities[graph.antiParallel[e]] += capacities[e];
+            capacities[e] = 0;
+        }
+
+    }
+
+    // Work loop executed by every thread. Thread 0 does the serial bookkeeping
+    // between the parallel phases.
+    void run(unsigned id)
+    {
+        while (true)
+        {
+            if (globalUpdateNeeded)
+                globalRelabel(id);
+
+            if (active.empty())
+                break;
+
+            long long localWork{0};
+            forEachDynamic(active, [&](T v)
+                           { localWork += discharge(v, id); });
+            work += localWork;
+            barrier.wait();
+
+            // Apply the new heights and excesses of the discharged vertices
+            std::size_t end = partitionBegin(active.size(), id + 1, threadCount);
+            for (std::size_t i = partitionBegin(active.size(), id, threadCount); i < end; ++i)
+            {
+                T v = active[i];
+                heights[v] = newHeights[v];
+                excessflow[v] += addedExcess[v].exchange(0, std::memory_order_relaxed);
+            }
+            barrier.wait();
+
+            // Apply the excess received by vertices that were not discharged
+            for (T v : discovered[id])
+            {
+                excessflow[v] += addedExcess[v].exchange(0, std::memory_order_relaxed);
+            }
+            barrier.wait();
+
+            if (id == 0)
+            {
+                gatherActive();
+            }
+            barrier.wait();
+        }
+    }
+
+    // Calls f for every item. Threads take chunks of items until none are left.
+    template <typename F>
+    void forEachDynamic(const std::vector<T> &items, F f)
+    {
+        const std::size_t chunkSize = 64;
+        while (true)
+        {
+            std::size_t begin = cursor.fetch_add(chunkSize, std::memory_order_relaxed);
+            if (begin >= items.size())
+                break;
+            std::size_t end = std::min(begin + chunkSize, items.size());
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                f(items[i]);
+            }
+        }
+    }
+
+    // Builds the active list of the next round from the vertices discovered
+    // by all threads.
+    void gatherActive()
+    {
+        active.clear();
+        for (auto &vertices : discovered)
+        {
+            for (T v : vertices)
+            {
+                if (excessflow[v] > 0 && heights[v] < graph.V)
+                    active.push_back(v);
+            }
+            vertices.clear();
+        }
+
+        epoch++;
+        cursor = 0;
+        workSinceUpdate += work.exchange(0);
+
+        // Heights may be lower than the residual distance to the sink after a
+        // round, so the algorithm only stops when exact heights confirm that
+        // no vertex with excess can reach the sink.
+        globalUpdateNeeded = active.empty() ||
+                             workSinceUpdate > 2 * (alpha * graph.V + (long long)graph.heads.size());
+    }
+
+    bool isActive(T v) const
+    {
+        return v != graph.source && v != graph.sink && excessflow[v] > 0 && heights[v] < graph.V;
+    }
+
+    // Decides which of two active vertices may use the arc pair between them.
+    bool wins(T v, T w) const
+    {
+        return heights[v] == heights[w] + 1 || heights[v] + 1 < heights[w] ||
+               (heights[v] == heights[w] && v < w);
+    }
+
+    // Discharges v against the heights from the start of the round.
+    // Returns the amount of work done.
+    long long discharge(T v, unsigned id)
+    {
+        U excess = excessflow[v];
+        T height = heights[v];
+        long long scanned{0};
+
+        while (excess > 0)
+        {
+            T minHeight = graph.V;
+            bool skipped = false;
+
+            for (T e = graph.offsets[v]; e < graph.offsets[v + 1] && excess > 0; ++e)
+            {
+                scanned++;
+                T w = graph.heads[e];
+                bool admissible = height == heights[w] + 1;
+
+                // The active vertex w may push over this arc pair during the
+                // round, so its capacities can not be read. Assuming the arc
+                // is residual keeps the new height valid.
+                if (isActive(w) && !wins(v, w))
+                {
+                    if (admissible)
+                    {
+                        skipped = true;
+                    }
+                    else if (heights[w] >= height)
+                    {
+                        minHeight = std::min<T>(minHeight, heights[w] + 1);
+                    }
+                    continue;
+                }
+
+                if (capacities[e] <= 0)
+                    continue;
+
+                if (admissible)
+                {
+                    U delta = std::min(capacities[e], excess);
+                    capacities[e] -= delta;
+                    capacities[graph.antiParallel[e]] += delta;
+                    excess -= delta;
+                    atomicAdd(addedExcess[w], delta);
+
+                    if (w != graph.sink && stamps[w].exchange(epoch, std::memory_order_relaxed) != epoch)
+                        discovered[id].push_back(w);
+                }
+
+                if (capacities[e] > 0 && heights[w] >= height)
+                {
+                    minHeight = std::min<T>(minHeight, heights[w] + 1);
+                }
+            }
+
+            if (excess == 0 || skipped)
+                break;
+
+            // Relabel
+            scanned += relabelWork;
+            height = std::min(minHeight, graph.V);
+            if (height == graph.V)
+                break;
+        }
+
+        newHeights[v] = height;
+        atomicAdd(addedExcess[v], excess - excessflow[v]);
+
+        if (excess > 0 && height < graph.V && stamps[v].exchange(epoch, std::memory_order_relaxed) != epoch)
+            discovered[id].push_back(v);
+
+        return scanned;
+    }
+
+    // Sets every height to the residual distance to the sink, or V if the
+    // sink can not be reached. Thread 0 runs the BFS as a plain queue while
+    // the others wait at the barrier. A threaded BFS would start threads of
+    // its own on every relabel, as many again as the parked workers.
+    void globalRelabel(unsigned id)
+    {
+        barrier.wait();
+        if (id == 0)
+        {
+            auto open = [this](T e)
+            {
+                return capacities[graph.antiParallel[e]] > 0;
+            };
+            bfs.search(graph, graph.sink, open, heights, nullptr, FrontierBFS<T>::none, graph.source);
+        }
+        barrier.wait();
+
+        // Rebuild the active list. Vertices that can not reach the sink stay inactive.
+        std::size_t end = partitionBegin(graph.V, id + 1, threadCount);
+        for (std::size_t v = partitionBegin(graph.V, id, threadCount); v < end; ++v)
+        {
+            if (isActive(v))
+                discovered[id].push_back(v);
+        }
+        barrier.wait();
+
+        if (id == 0)
+        {
+            active.clear();
+            for (auto &vertices : discovered)
+            {
+                active.insert(active.end(), vertices.begin(), vertices.end());
+                vertices.clear();
+            }
+            epoch++;
+            cursor = 0;
+            workSinceUpdate = 0;
+            globalUpdateNeeded = false;
+        }
+        barrier.wait();
+    }
+};
+
+#endif // PUSH_RELABEL_PARALLEL_H
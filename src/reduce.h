@@ -0,0 +1,361 @@
+#ifndef REDUCE_H
+#define REDUCE_H
+
+#include "graph.h"
+#include "graph_builder.h"
+#include "min_cut.h"
+#include "parallel.h"
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+// Flow sent straight from the source to the sink through one vertex, when
+// the terminal capacities of the vertex are cancelled
+template <typename T, typename U>
+struct TerminalPath
+{
+    T sourceArc;
+    T sinkArc;
+    U flow;
+};
+
+// How a reduced graph relates to the graph it was reduced from. The max flow
+// value of the graph is that of the reduced graph plus flowOffset, and a max
+// flow of the reduced graph lifts to a max flow of the graph.
+template <typename T, typename U>
+struct GraphReduction
+{
+    // Flow of the cancelled terminal capacities
+    U flowOffset{0};
+    std::vector<TerminalPath<T, U>> terminalPaths;
+
+    // Arc a of the reduced graph stands for the path of arcs
+    // pathArcs[pathOffsets[a]], ..., pathArcs[pathOffsets[a + 1] - 1] of the graph
+    std::vector<T> pathOffsets;
+    std::vector<T> pathArcs;
+
+    // vertices[n] is the vertex of the graph that is vertex n of the reduced graph
+    std::vector<T> vertices;
+
+    // Returns the residual capacities of the graph for the flow that the
+    // residual capacities of the reduced graph describe. Pruned vertices and
+    // the vertices of contracted chains carry flow only along the chains.
+    std::vector<U> liftResidualCapacities(const Graph<T, U> &graph, const Graph<T, U> &reduced, const std::vector<U> &reducedCapacities) const
+    {
+        std::vector<U> capacities(graph.capacities.begin(), graph.capacities.end());
+        auto send = [&](T e, U flow)
+        {
+            capacities[e] -= flow;
+            capacities[graph.antiParallel[e]] += flow;
+        };
+
+        for (const auto &path : terminalPaths)
+        {
+            send(path.sourceArc, path.flow);
+            send(path.sinkArc, path.flow);
+        }
+
+        for (std::size_t a{0}; a < reducedCapacities.size(); ++a)
+        {
+            U flow = reduced.capacities[a] - reducedCapacities[a];
+            if (flow <= 0)
+                continue;
+            for (T i = pathOffsets[a]; i < pathOffsets[a + 1]; ++i)
+                send(pathArcs[i], flow);
+        }
+        return capacities;
+    }
+
+    // Returns the source side of a minimum cut of the graph
+    std::vector<bool> liftMinCut(const Graph<T, U> &graph, const Graph<T, U> &reduced, const std::vector<U> &reducedCapacities) const
+    {
+        return findMinCut(graph, liftResidualCapacities(graph, reduced, reducedCapacities));
+    }
+};
+
+// Returns a smaller graph with the same max flow value, less the flowOffset
+// of reduction. Three reductions are made, in this order:
+//
+// - The source and sink capacity of every vertex with arcs from the source
+//   and to the sink are cancelled against each other, as flow sent along
+//   the path source -> vertex -> sink.
+// - Vertices that can not be reached from the source, or can not reach the
+//   sink, are removed. No flow path passes through them.
+// - Every chain of vertices with exactly two neighbours is contracted into an
+//   arc between its ends, with the minimum capacity along the chain in each
+//   direction. A chain back to where it started carries no flow and is
+//   removed. If its ends are already joined, the chain keeps its first
+//   vertex, so that no parallel arcs are made.
+//
+// The source and the sink are always kept, and kept vertices keep the order
+// of their ids.
+template <typename T, typename U>
+Graph<T, U> reduceGraph(const Graph<T, U> &graph, GraphReduction<T, U> &reduction)
+{
+    reduction = {};
+    std::vector<U> capacities(graph.capacities.begin(), graph.capacities.end());
+
+    // Cancel terminal capacities
+    for (T e = graph.offsets[graph.source]; e < graph.offsets[graph.source + 1]; ++e)
+    {
+        T v = graph.heads[e];
+        if (v == graph.source || v == graph.sink)
+            continue;
+        T f = graph.findArc(v, graph.sink);
+        if (f == static_cast<T>(graph.heads.size()))
+            continue;
+
+        U flow = std::min(capacities[e], capacities[f]);
+        if (flow > 0)
+        {
+            capacities[e] -= flow;
+            capacities[f] -= flow;
+            reduction.flowOffset += flow;
+            reduction.terminalPaths.push_back({e, f, flow});
+        }
+    }
+
+    // Prune by reachability from the source and to the sink
+    auto search = [&](T start, bool forward)
+    {
+        std::vector<bool> reached(graph.V, false);
+        std::vector<T> queue{start};
+        reached[start] = true;
+        for (std::size_t i{0}; i < queue.size(); ++i)
+        {
+            T u = queue[i];
+            for (T e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e)
+            {
+                T v = graph.heads[e];
+                if (!reached[v] && capacities[forward ? e : graph.antiParallel[e]] > 0)
+                {
+                    reached[v] = true;
+                    queue.push_back(v);
+                }
+            }
+        }
+        return reached;
+    };
+    std::vector<bool> kept = search(graph.source, true);
+    std::vector<bool> reachesSink = search(graph.sink, false);
+    for (T v{0}; v < graph.V; ++v)
+        kept[v] = (kept[v] && reachesSink[v]) || v == graph.source || v == graph.sink;
+
+    // An arc is used if it joins two kept vertices and has capacity in either direction
+    auto used = [&](T u, T e)
+    {
+        T v = graph.heads[e];
+        return v != u && kept[v] && (capacities[e] > 0 || capacities[graph.antiParallel[e]] > 0);
+    };
+
+    // A vertex is in a chain if it has exactly two neighbours. The arcs
+    // between neighbours come in one pair, so two used arcs are two neighbours.
+    std::vector<bool> inChain(graph.V, false);
+    for (T v{0}; v < graph.V; ++v)
+    {
+        if (!kept[v] || v == graph.source || v == graph.sink)
+            continue;
+        T neighbours{0};
+        for (T e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e)
+        {
+            if (graph.heads[e] == v)
+                neighbours = 3;
+            else if (used(v, e))
+                ++neighbours;
+        }
+        inChain[v] = neighbours == 2;
+    }
+
+    // Arcs of the reduced graph, with their tails and heads in graph ids.
+    // Arc i stands for the path paths[arcs[i].path], ..., paths[arcs[i + 1].path - 1].
+    struct ReducedArc
+    {
+        T u;
+        T v;
+        U capacity;
+        U reverseCapacity;
+        T path;
+    };
+    std::vector<ReducedArc> arcs;
+    std::vector<T> paths;
+    auto addArc = [&](T u, T v, T path)
+    {
+        U capacity = capacities[paths[path]];
+        U reverseCapacity = capacities[graph.antiParallel[paths[path]]];
+        for (std::size_t i = path; i < paths.size(); ++i)
+        {
+            capacity = std::min(capacity, capacities[paths[i]]);
+            reverseCapacity = std::min(reverseCapacity, capacities[graph.antiParallel[paths[i]]]);
+        }
+        arcs.push_back({u, v, capacity, reverseCapacity, path});
+    };
+
+    // Returns the arc leaving the chain vertex v other than the one back to from
+    auto next = [&](T v, T from)
+    {
+        for (T e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e)
+        {
+            if (used(v, e) && graph.heads[e] != from)
+                return e;
+        }
+        return graph.offsets[v + 1];
+    };
+
+    // All chains at a vertex are walked when it is reached in the loop
+    // below, so the chains from u lead to vertices after u, and joined[v] == u
+    // if u and v are already joined by an arc or a chain.
+    std::vector<T> joined(graph.V, graph.V);
+    std::vector<bool> walked(graph.V, false);
+    std::vector<bool> contracted(graph.V, false);
+
+    for (T u{0}; u < graph.V; ++u)
+    {
+        if (!kept[u] || inChain[u])
+            continue;
+        for (T e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e)
+        {
+            T v = graph.heads[e];
+            if (used(u, e) && !inChain[v])
+            {
+                joined[v] = u;
+
+                // Each arc pair between vertices outside chains is added once
+                if (u < v)
+                {
+                    paths.push_back(e);
+                    addArc(u, v, paths.size() - 1);
+                }
+            }
+        }
+
+        for (T e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e)
+        {
+            T v = graph.heads[e];
+            if (!used(u, e) || !inChain[v] || walked[v])
+                continue;
+
+            // Walk the chain from u to its other end
+            T path = paths.size();
+            paths.push_back(e);
+            T from = u;
+            while (inChain[v] && !walked[v])
+            {
+                walked[v] = true;
+                contracted[v] = true;
+                T f = next(v, from);
+                paths.push_back(f);
+                from = v;
+                v = graph.heads[f];
+            }
+
+            // A chain back to u carries no flow
+            if (v == u)
+            {
+                paths.resize(path);
+                continue;
+            }
+
+            if (joined[v] == u)
+            {
+                // Keep the first vertex of the chain, so the chain is u -> w -> v
+                T w = graph.heads[e];
+                contracted[w] = false;
+                std::vector<T> rest(paths.begin() + path + 1, paths.end());
+                paths.resize(path + 1);
+                addArc(u, w, path);
+                paths.insert(paths.end(), rest.begin(), rest.end());
+                addArc(w, v, path + 1);
+            }
+            else
+            {
+                joined[v] = u;
+                addArc(u, v, path);
+            }
+
+            if (arcs.back().capacity == 0 && arcs.back().reverseCapacity == 0)
+            {
+                paths.resize(arcs.back().path);
+                arcs.pop_back();
+            }
+        }
+    }
+
+    std::vector<T> newIds(graph.V, graph.V);
+    for (T v{0}; v < graph.V; ++v)
+    {
+        if (kept[v] && !contracted[v])
+        {
+            newIds[v] = reduction.vertices.size();
+            reduction.vertices.push_back(v);
+        }
+    }
+
+    GraphBuilder<T, U> builder(reduction.vertices.size(), newIds[graph.source], newIds[graph.sink]);
+    builder.reserve(2 * arcs.size());
+    for (const auto &arc : arcs)
+    {
+        builder.addArc(newIds[arc.u], newIds[arc.v], arc.capacity);
+        builder.addArc(newIds[arc.v], newIds[arc.u], arc.reverseCapacity);
+    }
+    Graph<T, U> reduced = builder.build();
+
+    // Arc pair i of the builder is the first arc pair of its tail with the
+    // head, and the anti-parallel arc gets the reversed path of anti-parallel arcs
+    auto pathLength = [&](std::size_t i)
+    {
+        return (i + 1 < arcs.size() ? arcs[i + 1].path : paths.size()) - arcs[i].path;
+    };
+    std::vector<T> byTail(arcs.size());
+    auto tail = [&](std::size_t i)
+    {
+        return newIds[arcs[i].u];
+    };
+    auto place = [&byTail](std::size_t i, T position)
+    {
+        byTail[position] = i;
+    };
+    std::vector<T> tailOffsets = countingSort<T>(arcs.size(), reduced.V, tail, place, 1);
+
+    // The arcs of a vertex are found by their heads, as arcAt[head]
+    std::vector<T> arcOf(reduced.heads.size());
+    std::vector<bool> reversed(reduced.heads.size());
+    std::vector<T> arcAt(reduced.V);
+    for (T x{0}; x < reduced.V; ++x)
+    {
+        for (T a = reduced.offsets[x]; a < reduced.offsets[x + 1]; ++a)
+            arcAt[reduced.heads[a]] = a;
+        for (T j = tailOffsets[x]; j < tailOffsets[x + 1]; ++j)
+        {
+            T i = byTail[j];
+            T a = arcAt[newIds[arcs[i].v]];
+            arcOf[a] = i;
+            reversed[a] = false;
+            arcOf[reduced.antiParallel[a]] = i;
+            reversed[reduced.antiParallel[a]] = true;
+        }
+    }
+
+    reduction.pathOffsets.resize(reduced.heads.size() + 1, 0);
+    for (std::size_t a{0}; a < reduced.heads.size(); ++a)
+        reduction.pathOffsets[a + 1] = reduction.pathOffsets[a] + pathLength(arcOf[a]);
+    reduction.pathArcs.resize(reduction.pathOffsets.back());
+    for (std::size_t a{0}; a < reduced.heads.size(); ++a)
+    {
+        auto first = paths.begin() + arcs[arcOf[a]].path;
+        auto last = first + pathLength(arcOf[a]);
+        auto position = reduction.pathArcs.begin() + reduction.pathOffsets[a];
+        if (!reversed[a])
+        {
+            std::copy(first, last, position);
+        }
+        else
+        {
+            while (last != first)
+                *position++ = graph.antiParallel[*--last];
+        }
+    }
+
+    return reduced;
+}
+
+#endif // REDUCE_H
@@ -0,0 +1,250 @@
+#ifndef REORDER_H
+#define REORDER_H
+
+#include "graph.h"
+#include "parallel.h"
+#include "types.h"
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+// Renumbering of the vertices of a graph, to improve the locality of the
+// searches of the solvers. Vertices that are searched together get nearby
+// ids, so the per-vertex arrays and the arcs are visited in runs instead of
+// at random.
+template <typename T>
+struct VertexReordering
+{
+    // order[n] is the original id of new vertex n, and newIds is its inverse
+    std::vector<T> order;
+    std::vector<T> newIds;
+
+    // arcs[a] is the original index of arc a of the reordered graph
+    std::vector<T> arcs;
+
+    // Returns per-vertex values of the reordered graph in the original order
+    template <typename X>
+    std::vector<X> toOriginalVertices(const std::vector<X> &values) const
+    {
+        std::vector<X> original(values.size());
+        for (std::size_t n{0}; n < values.size(); ++n)
+            original[order[n]] = values[n];
+        return original;
+    }
+
+    // Returns per-arc values of the reordered graph in the original order
+    template <typename X>
+    std::vector<X> toOriginalArcs(const std::vector<X> &values) const
+    {
+        std::vector<X> original(values.size());
+        for (std::size_t a{0}; a < values.size(); ++a)
+            original[arcs[a]] = values[a];
+        return original;
+    }
+};
+
+namespace VertexOrders
+{
+    template <typename T, typename U>
+    T degree(const Graph<T, U> &graph, T u)
+    {
+        return graph.offsets[u + 1] - graph.offsets[u];
+    }
+
+    // Appends the vertices reached by a BFS from start to order. The
+    // neighbours of a vertex are taken in the order given by its arcs, or by
+    // increasing degree if byDegree is set, as in Cuthill-McKee.
+    template <typename T, typename U>
+    void appendBfs(const Graph<T, U> &graph, T start, bool byDegree, std::vector<bool> &visited, std::vector<T> &order)
+    {
+        std::size_t first = order.size();
+        visited[start] = true;
+        order.push_back(start);
+
+        for (std::size_t i = first; i < order.size(); ++i)
+        {
+            T u = order[i];
+            std::size_t neighbours = order.size();
+            for (T e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e)
+            {
+                T v = graph.heads[e];
+                if (!visited[v])
+                {
+                    visited[v] = true;
+                    order.push_back(v);
+                }
+            }
+
+            if (byDegree)
+            {
+                std::stable_sort(order.begin() + neighbours, order.end(), [&graph](T a, T b)
+                                 { return degree(graph, a) < degree(graph, b); });
+            }
+        }
+    }
+
+    // BFS from the source, followed by BFS from the lowest unvisited id
+    // until all vertices are ordered
+    template <typename T, typename U>
+    std::vector<T> bfs(const Graph<T, U> &graph)
+    {
+        std::vector<bool> visited(graph.V, false);
+        std::vector<T> order;
+        order.reserve(graph.V);
+
+        appendBfs(graph, graph.source, false, visited, order);
+        for (T u{0}; u < graph.V; ++u)
+        {
+            if (!visited[u])
+                appendBfs(graph, u, false, visited, order);
+        }
+        return order;
+    }
+
+    // Reverse Cuthill-McKee: every component is ordered by a BFS from a
+    // vertex of lowest degree, with neighbours taken by increasing degree,
+    // and the whole order is reversed. Keeps the ids of adjacent vertices
+    // close together.
+    template <typename T, typename U>
+    std::vector<T> reverseCuthillMcKee(const Graph<T, U> &graph)
+    {
+        std::vector<T> byDegree(graph.V);
+        std::iota(byDegree.begin(), byDegree.end(), 0);
+        std::stable_sort(byDegree.begin(), byDegree.end(), [&graph](T a, T b)
+                         { return degree(graph, a) < degree(graph, b); });
+
+        std::vector<bool> visited(graph.V, false);
+        std::vector<T> order;
+        order.reserve(graph.V);
+        for (T u : byDegree)
+        {
+            if (!visited[u])
+                appendBfs(graph, u, true, visited, order);
+        }
+
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+
+    // Decreasing degree, so the vertices with most arcs share cache lines
+    template <typename T, typename U>
+    std::vector<T> decreasingDegree(const Graph<T, U> &graph, unsigned threadCount)
+    {
+        T maxDegree{0};
+        for (T u{0}; u < graph.V; ++u)
+            maxDegree = std::max(maxDegree, degree(graph, u));
+
+        std::vector<T> order(graph.V);
+        auto key = [&](std::size_t u)
+        {
+            return maxDegree - degree(graph, static_cast<T>(u));
+        };
+        auto place = [&order](std::size_t u, T position)
+        {
+            order[position] = u;
+        };
+        countingSort<T>(graph.V, maxDegree + 1, key, place, threadCount);
+        return order;
+    }
+}
+
+// Returns the graph with vertex n being vertex order[n] of graph. The arcs
+// of every vertex are sorted by the new id of their head, so a scan of them
+// also moves forward through the per-vertex arrays. The mapping back to the
+// original ids is stored in reordering.
+template <typename T, typename U>
+Graph<T, U> renumberVertices(const Graph<T, U> &graph, std::vector<T> order, VertexReordering<T> &reordering, unsigned threadCount = 1)
+{
+    if (order.size() != static_cast<std::size_t>(graph.V))
+    {
+        throw std::logic_error("The vertex order must contain every vertex once.");
+    }
+    threadCount = std::max(1u, threadCount);
+
+    std::vector<T> newIds(graph.V, graph.V);
+    for (T n{0}; n < graph.V; ++n)
+    {
+        if (order[n] < 0 || order[n] >= graph.V || newIds[order[n]] != graph.V)
+        {
+            throw std::logic_error("The vertex order must contain every vertex once.");
+        }
+        newIds[order[n]] = n;
+    }
+
+    const std::size_t arcCount = graph.heads.size();
+    std::vector<T> offsets(graph.V + 1, 0);
+    for (T n{0}; n < graph.V; ++n)
+        offsets[n + 1] = offsets[n] + (graph.offsets[order[n] + 1] - graph.offsets[order[n]]);
+
+    std::vector<T> heads(arcCount);
+    std::vector<U> capacities(arcCount);
+    std::vector<T> antiParallel(arcCount);
+    std::vector<T> arcs(arcCount);
+    std::vector<T> newArcs(arcCount);
+
+    auto placeArcs = [&](unsigned id)
+    {
+        T end = partitionBegin(graph.V, id + 1, threadCount);
+        for (T n = partitionBegin(graph.V, id, threadCount); n < end; ++n)
+        {
+            T first = offsets[n];
+            std::iota(arcs.begin() + first, arcs.begin() + offsets[n + 1], graph.offsets[order[n]]);
+            std::sort(arcs.begin() + first, arcs.begin() + offsets[n + 1], [&](T a, T b)
+                      { return newIds[graph.heads[a]] < newIds[graph.heads[b]]; });
+
+            for (T a = first; a < offsets[n + 1]; ++a)
+            {
+                newArcs[arcs[a]] = a;
+                heads[a] = newIds[graph.heads[arcs[a]]];
+                capacities[a] = graph.capacities[arcs[a]];
+            }
+        }
+    };
+    runInParallel(threadCount, placeArcs);
+
+    auto pairArcs = [&](unsigned id)
+    {
+        std::size_t end = partitionBegin(arcCount, id + 1, threadCount);
+        for (std::size_t a = partitionBegin(arcCount, id, threadCount); a < end; ++a)
+            antiParallel[a] = newArcs[graph.antiParallel[arcs[a]]];
+    };
+    runInParallel(threadCount, pairArcs);
+
+    Graph<T, U> renumbered(graph.V, graph.E, newIds[graph.source], newIds[graph.sink]);
+    renumbered.offsets = std::move(offsets);
+    renumbered.heads = std::move(heads);
+    renumbered.capacities = std::move(capacities);
+    renumbered.antiParallel = std::move(antiParallel);
+
+    reordering.order = std::move(order);
+    reordering.newIds = std::move(newIds);
+    reordering.arcs = std::move(arcs);
+    return renumbered;
+}
+
+// Returns the graph renumbered in the given vertex order
+template <typename T, typename U>
+Graph<T, U> reorderVertices(const Graph<T, U> &graph, VertexOrder vertexOrder, VertexReordering<T> &reordering, unsigned threadCount = 1)
+{
+    std::vector<T> order;
+    switch (vertexOrder)
+    {
+    case VertexOrder::bfs:
+        order = VertexOrders::bfs(graph);
+        break;
+    case VertexOrder::rcm:
+        order = VertexOrders::reverseCuthillMcKee(graph);
+        break;
+    case VertexOrder::degree:
+        order = VertexOrders::decreasingDegree(graph, threadCount);
+        break;
+    default:
+        order.resize(graph.V);
+        std::iota(order.begin(), order.end(), 0);
+        break;
+    }
+    return renumberVertices(graph, std::move(order), reordering, threadCount);
+}
+
+#endif // REORDER_H
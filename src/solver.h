@@ -4,50 +4,445 @@
 #include "edmonds_karp.h"
 #include "dinic.h"
 #include "push_relabel.h"
+#include "push_relabel_parallel.h"
+#include "push_relabel_highest_label.h"
+#include "capacity_scaling.h"
+#include "boykov_kolmogorov.h"
+#include "pseudoflow.h"
+#include "unit_capacity.h"
+#include "parametric.h"
+#include "reorder.h"
+#include "reduce.h"
+#include "grid_graph.h"
+#include "stats.h"
+#include "cancellation.h"
 #include <iostream>
+#include <iomanip>
 #include <chrono>
+#include <limits>
+#include <memory>
 #include <types.h>
 
-void printResult(const int maxflowValue, const std::chrono::microseconds algorithmTime, AlgorithmEnums::Algorithm algorithm)
+template <typename U>
+void printResult(const U maxflowValue, const std::chrono::microseconds algorithmTime, AlgorithmEnums::Algorithm algorithm)
 {
     std::cout << "Algorithm used: " << AlgorithmEnums::enumToString(algorithm) << '\n';
-    std::cout << "maxflow value: " << maxflowValue << '\n';
+    std::cout << "maxflow value: " << std::setprecision(std::numeric_limits<U>::digits10) << maxflowValue << '\n';
     std::cout << "time (microseconds): " << algorithmTime.count() << '\n';
 }
 
+// Prints the bounds of a solve stopped before the max flow value was known
+template <typename U>
+void printBounds(const FlowBounds<U> &bounds, const std::chrono::microseconds algorithmTime, AlgorithmEnums::Algorithm algorithm)
+{
+    std::cout << "Algorithm used: " << AlgorithmEnums::enumToString(algorithm) << '\n';
+    std::cout << std::setprecision(std::numeric_limits<U>::digits10)
+              << "time limit reached\n"
+              << "maxflow lower bound: " << bounds.lower << '\n'
+              << "maxflow upper bound: " << bounds.upper << '\n';
+    std::cout << "time (microseconds): " << algorithmTime.count() << '\n';
+}
+
+// The solver that runs for the algorithm on the graph. "auto" runs "unit"
+// on graphs whose capacities are all 0 or 1, and "dinic" on others. The
+// reduction never raises a capacity, so the choice holds for the reduced
+// graph too. Every other algorithm runs as itself.
+template <typename T, typename U>
+AlgorithmEnums::Algorithm resolveAlgorithm(AlgorithmEnums::Algorithm algorithm, const Graph<T, U> &graph)
+{
+    if (algorithm != AlgorithmEnums::Algorithm::automatic)
+        return algorithm;
+    return isUnitCapacity(graph) ? AlgorithmEnums::Algorithm::unit : AlgorithmEnums::Algorithm::dinic;
+}
+
+// "auto" runs "dinic" on a grid graph, which solves the grid itself
+template <typename T, typename U>
+AlgorithmEnums::Algorithm resolveAlgorithm(AlgorithmEnums::Algorithm algorithm, const GridGraph<T, U> &)
+{
+    if (algorithm != AlgorithmEnums::Algorithm::automatic)
+        return algorithm;
+    return AlgorithmEnums::Algorithm::dinic;
+}
+
+// Runs the algorithm on the graph and returns the max flow value. The
+// counters of the solver are added to stats, if given. If the options ask
+// for it, the reduced graph is solved instead, and the reduction time is
+// part of the time of the call.
 template <typename T = int, typename U = int>
-void solve(const AlgorithmEnums::Algorithm &algorithm, Graph<T, U> *graph)
+U findMaxFlow(const AlgorithmEnums::Algorithm &algorithm, const Graph<T, U> &graph, const SolverOptions &options = {}, Stats *stats = nullptr)
 {
-    auto start = std::chrono::high_resolution_clock::now();
-    int maxflowValue{0};
+    if (algorithm == AlgorithmEnums::Algorithm::automatic)
+        return findMaxFlow(resolveAlgorithm(algorithm, graph), graph, options, stats);
+
+    if (options.reduce)
+    {
+        Stopwatch reduceStopwatch;
+        GraphReduction<T, U> reduction;
+        const Graph<T, U> reduced = reduceGraph(graph, reduction);
+        if (stats)
+            stats->reduceTime = reduceStopwatch.stop();
+
+        SolverOptions reducedOptions = options;
+        reducedOptions.reduce = false;
+        return reduction.flowOffset + findMaxFlow(algorithm, reduced, reducedOptions, stats);
+    }
+
+    unsigned threadCount = options.threadCount ? options.threadCount : defaultThreadCount();
+    // The searches of ek, dinic and hipr run in parallel only when asked to
+    unsigned searchThreadCount = options.threadCount ? options.threadCount : 1;
     switch (algorithm)
     {
     case AlgorithmEnums::Algorithm::ek:
     {
-        EdmondsKarp<T, U> edmondsKarp(*graph);
-        maxflowValue = edmondsKarp.findMaxFlow();
+        EdmondsKarp<T, U> edmondsKarp(graph, searchThreadCount);
+        U maxflow = edmondsKarp.findMaxFlow();
+        if (stats)
+            stats->addCounters(edmondsKarp.getStats());
+        return maxflow;
     }
-    break;
-
     case AlgorithmEnums::Algorithm::dinic:
     {
-        Dinic<T, U> dinic(*graph);
-        maxflowValue = dinic.findMaxFlow();
+        Dinic<T, U> dinic(graph, searchThreadCount);
+        U maxflow = dinic.findMaxFlow();
+        if (stats)
+            stats->addCounters(dinic.getStats());
+        return maxflow;
     }
-    break;
     case AlgorithmEnums::Algorithm::pr:
     {
-        PushRelabel<T, U> pushRelabel(*graph);
-        maxflowValue = pushRelabel.findMaxFlow();
+        PushRelabel<T, U> pushRelabel(graph);
+        U maxflow = pushRelabel.findMaxFlow();
+        if (stats)
+            stats->addCounters(pushRelabel.getStats());
+        return maxflow;
+    }
+    case AlgorithmEnums::Algorithm::prpar:
+    {
+        ParallelPushRelabel<T, U> parallelPushRelabel(graph, threadCount);
+        return parallelPushRelabel.findMaxFlow();
+    }
+    case AlgorithmEnums::Algorithm::hipr:
+    {
+        HighestLabelPushRelabel<T, U> highestLabelPushRelabel(graph, searchThreadCount);
+        if (options.valueOnly)
+            return highestLabelPushRelabel.findMaxPreflow();
+        return highestLabelPushRelabel.findMaxFlow();
+    }
+    case AlgorithmEnums::Algorithm::scaling:
+    {
+        CapacityScaling<T, U> capacityScaling(graph);
+        return capacityScaling.findMaxFlow();
+    }
+    case AlgorithmEnums::Algorithm::bk:
+    {
+        BoykovKolmogorov<T, U> boykovKolmogorov(graph);
+        return boykovKolmogorov.findMaxFlow();
+    }
+    case AlgorithmEnums::Algorithm::hpf:
+    {
+        Pseudoflow<T, U> pseudoflow(graph);
+        return pseudoflow.findMaxFlow();
+    }
+    case AlgorithmEnums::Algorithm::unit:
+    {
+        UnitCapacityDinic<T, U> unitCapacityDinic(graph);
+        U maxflow = unitCapacityDinic.findMaxFlow();
+        if (stats)
+            stats->addCounters(unitCapacityDinic.getStats());
+        return maxflow;
     }
-    break;
     default:
         throw std::logic_error("Unknown algorithm");
     }
+}
+
+// Runs the algorithm on the graph until it finishes or the token expires,
+// and returns bounds on the max flow value. Only the algorithms for which
+// AlgorithmEnums::isStoppable holds can be stopped; "hipr" only runs its
+// first phase, which finds the value. Options and stats are handled as by
+// findMaxFlow().
+template <typename T, typename U>
+FlowBounds<U> findFlowBounds(const AlgorithmEnums::Algorithm &algorithm, const Graph<T, U> &graph, CancellationToken &token,
+                             const SolverOptions &options = {}, Stats *stats = nullptr)
+{
+    if (algorithm == AlgorithmEnums::Algorithm::automatic)
+        return findFlowBounds(resolveAlgorithm(algorithm, graph), graph, token, options, stats);
+
+    if (options.reduce)
+    {
+        Stopwatch reduceStopwatch;
+        GraphReduction<T, U> reduction;
+        const Graph<T, U> reduced = reduceGraph(graph, reduction);
+        if (stats)
+            stats->reduceTime = reduceStopwatch.stop();
+
+        SolverOptions reducedOptions = options;
+        reducedOptions.reduce = false;
+        FlowBounds<U> bounds = findFlowBounds(algorithm, reduced, token, reducedOptions, stats);
+        return {bounds.lower + reduction.flowOffset, bounds.upper + reduction.flowOffset};
+    }
+
+    // The searches of ek, dinic and hipr run in parallel only when asked to
+    unsigned searchThreadCount = options.threadCount ? options.threadCount : 1;
+    switch (algorithm)
+    {
+    case AlgorithmEnums::Algorithm::ek:
+    {
+        EdmondsKarp<T, U> edmondsKarp(graph, searchThreadCount);
+        FlowBounds<U> bounds = edmondsKarp.findFlowBounds(token);
+        if (stats)
+            stats->addCounters(edmondsKarp.getStats());
+        return bounds;
+    }
+    case AlgorithmEnums::Algorithm::dinic:
+    {
+        Dinic<T, U> dinic(graph, searchThreadCount);
+        FlowBounds<U> bounds = dinic.findFlowBounds(token);
+        if (stats)
+            stats->addCounters(dinic.getStats());
+        return bounds;
+    }
+    case AlgorithmEnums::Algorithm::pr:
+    {
+        PushRelabel<T, U> pushRelabel(graph);
+        FlowBounds<U> bounds = pushRelabel.findFlowBounds(token);
+        if (stats)
+            stats->addCounters(pushRelabel.getStats());
+        return bounds;
+    }
+    case AlgorithmEnums::Algorithm::hipr:
+    {
+        HighestLabelPushRelabel<T, U> highestLabelPushRelabel(graph, searchThreadCount);
+        return highestLabelPushRelabel.findFlowBounds(token);
+    }
+    case AlgorithmEnums::Algorithm::unit:
+    {
+        UnitCapacityDinic<T, U> unitCapacityDinic(graph);
+        FlowBounds<U> bounds = unitCapacityDinic.findFlowBounds(token);
+        if (stats)
+            stats->addCounters(unitCapacityDinic.getStats());
+        return bounds;
+    }
+    default:
+        throw std::logic_error(AlgorithmEnums::enumToString(algorithm) + " can not be stopped early");
+    }
+}
+
+// Runs the algorithm on a grid graph and returns the max flow value. "bk"
+// and "dinic" run on the grid itself. The other algorithms, and the
+// reduction, run on the grid converted to a Graph, and the conversion is
+// part of the time of the call.
+template <typename T, typename U>
+U findMaxFlow(const AlgorithmEnums::Algorithm &algorithm, const GridGraph<T, U> &grid, const SolverOptions &options = {}, Stats *stats = nullptr)
+{
+    if (algorithm == AlgorithmEnums::Algorithm::automatic)
+        return findMaxFlow(resolveAlgorithm(algorithm, grid), grid, options, stats);
+
+    unsigned threadCount = options.threadCount ? options.threadCount : defaultThreadCount();
+    // The searches of dinic run in parallel only when asked to
+    unsigned searchThreadCount = options.threadCount ? options.threadCount : 1;
+    if (algorithm == AlgorithmEnums::Algorithm::dinic && !options.reduce)
+    {
+        Dinic<T, U, GridGraph<T, U>> dinic(grid, searchThreadCount);
+        U maxflow = dinic.findMaxFlow();
+        if (stats)
+            stats->addCounters(dinic.getStats());
+        return maxflow;
+    }
+    if (algorithm == AlgorithmEnums::Algorithm::bk && !options.reduce)
+    {
+        BoykovKolmogorov<T, U, GridGraph<T, U>> boykovKolmogorov(grid);
+        return boykovKolmogorov.findMaxFlow();
+    }
+
+    const Graph<T, U> graph = gridToGraph(grid, threadCount);
+    return findMaxFlow(algorithm, graph, options, stats);
+}
+
+// Bounds on the max flow value of a grid graph, as findFlowBounds() for a
+// Graph. "dinic" runs on the grid itself, the other algorithms on the grid
+// converted to a Graph.
+template <typename T, typename U>
+FlowBounds<U> findFlowBounds(const AlgorithmEnums::Algorithm &algorithm, const GridGraph<T, U> &grid, CancellationToken &token,
+                             const SolverOptions &options = {}, Stats *stats = nullptr)
+{
+    if (algorithm == AlgorithmEnums::Algorithm::automatic)
+        return findFlowBounds(resolveAlgorithm(algorithm, grid), grid, token, options, stats);
+
+    unsigned threadCount = options.threadCount ? options.threadCount : defaultThreadCount();
+    // The searches of dinic run in parallel only when asked to
+    unsigned searchThreadCount = options.threadCount ? options.threadCount : 1;
+    if (algorithm == AlgorithmEnums::Algorithm::dinic && !options.reduce)
+    {
+        Dinic<T, U, GridGraph<T, U>> dinic(grid, searchThreadCount);
+        FlowBounds<U> bounds = dinic.findFlowBounds(token);
+        if (stats)
+            stats->addCounters(dinic.getStats());
+        return bounds;
+    }
+
+    const Graph<T, U> graph = gridToGraph(grid, threadCount);
+    return findFlowBounds(algorithm, graph, token, options, stats);
+}
+
+// Solves the graph, a Graph or a GridGraph, and prints the result. The solve
+// time and the solver counters are added to stats, which are printed as
+// JSON if the options ask for it. With a time limit, the solve may stop
+// early, and then bounds on the max flow value are printed instead. For
+// "auto", the solver it picked is printed.
+template <typename G>
+void solve(const AlgorithmEnums::Algorithm &requested, const G *graph, const SolverOptions &options = {}, Stats stats = {})
+{
+    const AlgorithmEnums::Algorithm algorithm = resolveAlgorithm(requested, *graph);
+    using U = decltype(findMaxFlow(algorithm, *graph, options));
+    FlowBounds<U> bounds;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    if (options.timeLimit > 0)
+    {
+        CancellationToken token(secondsToDuration(options.timeLimit));
+        bounds = findFlowBounds(algorithm, *graph, token, options, &stats);
+    }
+    else
+    {
+        U maxflowValue = findMaxFlow(algorithm, *graph, options, &stats);
+        bounds = {maxflowValue, maxflowValue};
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto algorithmTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+    if (bounds.isExact())
+        printResult(bounds.lower, algorithmTime, algorithm);
+    else
+        printBounds(bounds, algorithmTime, algorithm);
+    if (options.vertexOrder != VertexOrder::none)
+        std::cout << "reorder time (microseconds): " << stats.reorderTime.count() << '\n';
+    if (options.reduce)
+        std::cout << "reduce time (microseconds): " << stats.reduceTime.count() << '\n';
+
+    if (options.printStats)
+    {
+        stats.solveTime = algorithmTime;
+        stats.printJson(std::cout);
+    }
+}
+
+// Solves the graph with the first phase of hipr, as --value-only asks, and
+// prints the max flow value and the source side of a minimum cut, read from
+// the maximum preflow. The vertices are printed as by
+// solveParametricProblem(). With a time limit, bounds are printed instead
+// if the phase does not finish. Finding the cut is part of the solve time.
+template <typename T, typename U>
+void solveValueOnly(const Graph<T, U> *graph, const SolverOptions &options, Stats stats = {}, const VertexReordering<T> *reordering = nullptr)
+{
+    const AlgorithmEnums::Algorithm algorithm = AlgorithmEnums::Algorithm::hipr;
+    const unsigned threadCount = options.threadCount ? options.threadCount : 1;
+    auto token = options.timeLimit > 0
+                     ? std::make_unique<CancellationToken>(secondsToDuration(options.timeLimit))
+                     : std::make_unique<CancellationToken>();
+
+    // Runs phase one on the graph and returns the bounds and the residual capacities
+    auto findPreflow = [&](const Graph<T, U> &solved, std::vector<U> &residualCapacities)
+    {
+        HighestLabelPushRelabel<T, U> highestLabelPushRelabel(solved, threadCount);
+        FlowBounds<U> bounds = highestLabelPushRelabel.findFlowBounds(*token);
+        residualCapacities = highestLabelPushRelabel.getResidualCapacities();
+        return bounds;
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+    FlowBounds<U> bounds;
+    std::vector<U> residualCapacities;
+    std::vector<bool> sourceSide;
+    if (options.reduce)
+    {
+        Stopwatch reduceStopwatch;
+        GraphReduction<T, U> reduction;
+        const Graph<T, U> reduced = reduceGraph(*graph, reduction);
+        stats.reduceTime = reduceStopwatch.stop();
+
+        bounds = findPreflow(reduced, residualCapacities);
+        bounds = {bounds.lower + reduction.flowOffset, bounds.upper + reduction.flowOffset};
+        if (bounds.isExact())
+            sourceSide = reduction.liftMinCut(*graph, reduced, residualCapacities);
+    }
+    else
+    {
+        bounds = findPreflow(*graph, residualCapacities);
+        if (bounds.isExact())
+            sourceSide = findMinCut(*graph, residualCapacities);
+    }
     auto end = std::chrono::high_resolution_clock::now();
     auto algorithmTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
 
-    printResult(maxflowValue, algorithmTime, algorithm);
+    if (!bounds.isExact())
+    {
+        printBounds(bounds, algorithmTime, algorithm);
+    }
+    else
+    {
+        if (reordering)
+            sourceSide = reordering->toOriginalVertices(sourceSide);
+        std::cout << "Algorithm used: " << AlgorithmEnums::enumToString(algorithm) << '\n';
+        std::cout << "maxflow value: " << std::setprecision(std::numeric_limits<U>::digits10) << bounds.lower << '\n';
+        std::cout << "source side:";
+        for (T v{0}; v < graph->V; ++v)
+        {
+            if (sourceSide[v])
+                std::cout << ' ' << v + 1;
+        }
+        std::cout << '\n';
+        std::cout << "time (microseconds): " << algorithmTime.count() << '\n';
+    }
+    if (options.vertexOrder != VertexOrder::none)
+        std::cout << "reorder time (microseconds): " << stats.reorderTime.count() << '\n';
+    if (options.reduce)
+        std::cout << "reduce time (microseconds): " << stats.reduceTime.count() << '\n';
+
+    if (options.printStats)
+    {
+        stats.solveTime = algorithmTime;
+        stats.printJson(std::cout);
+    }
+}
+
+// Solves the parametric problem at the lambdas of the options, and prints
+// the max flow value and the source side of a minimum cut for each lambda.
+// The vertices are printed with their DIMACS ids, mapped back through
+// reordering if the graph was renumbered.
+template <typename T = int, typename U = int>
+void solveParametricProblem(const Graph<T, U> *graph, const SolverOptions &options, const VertexReordering<T> *reordering = nullptr)
+{
+    std::vector<U> lambdas;
+    for (double lambda : options.lambdas)
+    {
+        if (!(lambda >= std::numeric_limits<U>::lowest() && lambda <= std::numeric_limits<U>::max()) ||
+            static_cast<double>(static_cast<U>(lambda)) != lambda)
+        {
+            throw std::invalid_argument("Lambda " + std::to_string(lambda) + " is not a valid capacity");
+        }
+        lambdas.push_back(static_cast<U>(lambda));
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto results = solveParametric(*graph, lambdas);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Algorithm used: Parametric " << AlgorithmEnums::enumToString(AlgorithmEnums::Algorithm::pr) << '\n';
+    for (auto &result : results)
+    {
+        if (reordering)
+            result.sourceSide = reordering->toOriginalVertices(result.sourceSide);
+        std::cout << std::setprecision(std::numeric_limits<U>::digits10)
+                  << "lambda: " << result.lambda << ", maxflow value: " << result.maxflow << ", source side:";
+        for (T v{0}; v < graph->V; ++v)
+        {
+            if (result.sourceSide[v])
+                std::cout << ' ' << v + 1;
+        }
+        std::cout << '\n';
+    }
+    std::cout << "time (microseconds): " << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << '\n';
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,108 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <chrono>
+#include <ostream>
+
+#ifdef MAXFLOW_STATS
+constexpr bool statsEnabled = true;
+#else
+constexpr bool statsEnabled = false;
+#endif
+
+// Counts an event in a solver. Unless MAXFLOW_STATS is defined, counting
+// compiles to nothing and the count stays 0.
+class Counter
+{
+public:
+    void operator++()
+    {
+        if constexpr (statsEnabled)
+            count++;
+    }
+
+    void operator+=(unsigned long long amount)
+    {
+        if constexpr (statsEnabled)
+            count += amount;
+    }
+
+    unsigned long long value() const
+    {
+        return count;
+    }
+
+private:
+    unsigned long long count{0};
+};
+
+// Counters of the solvers, and the time spent in every stage of a run.
+// Edmonds-Karp, Dinic and Push-Relabel collect the counters that apply to them.
+struct Stats
+{
+    Counter augmentingPaths;
+    Counter arcsScanned;
+    Counter phases;
+    Counter saturatingPushes;
+    Counter nonSaturatingPushes;
+    Counter relabels;
+    Counter gaps;
+    Counter gapVertices;
+
+    std::chrono::microseconds parseTime{0};
+    std::chrono::microseconds buildTime{0};
+    std::chrono::microseconds reorderTime{0};
+    std::chrono::microseconds reduceTime{0};
+    std::chrono::microseconds solveTime{0};
+
+    // Adds the counters, but not the times, of other
+    void addCounters(const Stats &other)
+    {
+        augmentingPaths += other.augmentingPaths.value();
+        arcsScanned += other.arcsScanned.value();
+        phases += other.phases.value();
+        saturatingPushes += other.saturatingPushes.value();
+        nonSaturatingPushes += other.nonSaturatingPushes.value();
+        relabels += other.relabels.value();
+        gaps += other.gaps.value();
+        gapVertices += other.gapVertices.value();
+    }
+
+    // Writes the times in microseconds, and the counters if they are collected
+    void printJson(std::ostream &out) const
+    {
+        out << "{\"times_us\": {\"parse\": " << parseTime.count()
+            << ", \"build\": " << buildTime.count()
+            << ", \"reorder\": " << reorderTime.count()
+            << ", \"reduce\": " << reduceTime.count()
+            << ", \"solve\": " << solveTime.count() << "}";
+
+        if constexpr (statsEnabled)
+        {
+            out << ", \"counters\": {\"augmenting_paths\": " << augmentingPaths.value()
+                << ", \"arcs_scanned\": " << arcsScanned.value()
+                << ", \"phases\": " << phases.value()
+                << ", \"saturating_pushes\": " << saturatingPushes.value()
+                << ", \"non_saturating_pushes\": " << nonSaturatingPushes.value()
+                << ", \"relabels\": " << relabels.value()
+                << ", \"gaps\": " << gaps.value()
+                << ", \"gap_vertices\": " << gapVertices.value() << "}";
+        }
+        out << "}\n";
+    }
+};
+
+// Measures the time from its construction to the call of stop()
+class Stopwatch
+{
+public:
+    std::chrono::microseconds stop() const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    }
+
+private:
+    std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+};
+
+#endif // STATS_H
@@ -2,6 +2,7 @@
 #define TYPES_H
 
 #include <string>
+#include <vector>
 #include <stdexcept>
 #include <algorithm>
 #include <cctype>
@@ -15,8 +16,35 @@ namespace AlgorithmEnums
         dinic,
         pr,
         prpar,
+        hipr,
+        scaling,
+        bk,
+        hpf,
+        unit,
+        automatic,
     };
 
+    // Every solver, in the order of the enum. "auto" is not one: it picks
+    // "unit" or "dinic" for the graph.
+    constexpr Algorithm allAlgorithms[] = {
+        Algorithm::ek,
+        Algorithm::dinic,
+        Algorithm::pr,
+        Algorithm::prpar,
+        Algorithm::hipr,
+        Algorithm::scaling,
+        Algorithm::bk,
+        Algorithm::hpf,
+        Algorithm::unit,
+    };
+
+    // Algorithms that can be stopped early, by a time limit or a cancellation
+    inline bool isStoppable(Algorithm algo)
+    {
+        return algo == Algorithm::ek || algo == Algorithm::dinic || algo == Algorithm::pr ||
+               algo == Algorithm::hipr || algo == Algorithm::unit || algo == Algorithm::automatic;
+    }
+
     inline std::string enumToString(Algorithm algo)
     {
         switch (algo)
@@ -27,6 +55,20 @@ namespace AlgorithmEnums
             return "Dinic's algorithm";
         case Algorithm::pr:
             return "Push-Relabel";
+        case Algorithm::prpar:
+            return "Parallel Push-Relabel";
+        case Algorithm::hipr:
+            return "Highest-Label Push-Relabel";
+        case Algorithm::scaling:
+            return "Capacity Scaling";
+        case Algorithm::bk:
+            return "Boykov-Kolmogorov";
+        case Algorithm::hpf:
+            return "Pseudoflow (Hochbaum)";
+        case Algorithm::unit:
+            return "Unit-Capacity Dinic";
+        case Algorithm::automatic:
+            return "Automatic";
         default:
             throw std::invalid_argument("Invalid Algorithm enum");
         }
@@ -43,9 +85,72 @@ namespace AlgorithmEnums
             return Algorithm::dinic;
         else if (lowerStr == "pr")
             return Algorithm::pr;
+        else if (lowerStr == "prpar")
+            return Algorithm::prpar;
+        else if (lowerStr == "hipr")
+            return Algorithm::hipr;
+        else if (lowerStr == "scaling")
+            return Algorithm::scaling;
+        else if (lowerStr == "bk")
+            return Algorithm::bk;
+        else if (lowerStr == "hpf")
+            return Algorithm::hpf;
+        else if (lowerStr == "unit")
+            return Algorithm::unit;
+        else if (lowerStr == "auto")
+            return Algorithm::automatic;
         else
             throw std::invalid_argument(str + " is not a regognized algorithm");
     }
 }
 
+// Order the vertices are renumbered in before solving
+enum class VertexOrder
+{
+    none,
+    bfs,
+    rcm,
+    degree,
+};
+
+inline VertexOrder stringToVertexOrder(const std::string &str)
+{
+    if (str == "none")
+        return VertexOrder::none;
+    else if (str == "bfs")
+        return VertexOrder::bfs;
+    else if (str == "rcm")
+        return VertexOrder::rcm;
+    else if (str == "degree")
+        return VertexOrder::degree;
+    else
+        throw std::invalid_argument(str + " is not a recognized vertex order");
+}
+
+// Settings that apply to the solvers, set from the command line.
+struct SolverOptions
+{
+    // Number of threads used by the parallel algorithms. 0 means one per hardware thread for
+    // prpar and reading, and one for the searches of ek, dinic and hipr.
+    unsigned threadCount{0};
+
+    // Stop hipr after phase one, which finds the max flow value and a minimum cut but not a flow.
+    bool valueOnly{false};
+
+    // Print the times of reading, building and solving, and the solver counters, as JSON.
+    bool printStats{false};
+
+    // Solve the parametric problem at these values of lambda with pr, instead of the graph as given.
+    std::vector<double> lambdas;
+
+    // Renumber the vertices in this order before solving. Results are reported with the original ids.
+    VertexOrder vertexOrder{VertexOrder::none};
+
+    // Reduce the graph before solving: cancel terminal capacities, prune dead vertices and contract chains.
+    bool reduce{false};
+
+    // Stop the solve after this many seconds, and report bounds on the max flow value. 0 means no limit.
+    double timeLimit{0};
+};
+
 #endif // TYPES_H
\ No newline at end of file
@@ -0,0 +1,284 @@
+#ifndef UNIT_CAPACITY_H
+#define UNIT_CAPACITY_H
+
+#include "graph.h"
+#include "stats.h"
+#include "min_cut.h"
+#include "cancellation.h"
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+// Returns true if every arc has capacity 0 or 1, as in unit networks and
+// bipartite matching
+template <typename T, typename U>
+bool isUnitCapacity(const Graph<T, U> &graph)
+{
+    return std::all_of(graph.capacities.begin(), graph.capacities.end(), [](U capacity)
+                       { return capacity == 0 || capacity == 1; });
+}
+
+// Dinic's algorithm for graphs whose arcs all have capacity 0 or 1. Every
+// augmenting path carries one unit, so a phase is one of Hopcroft and Karp:
+// a BFS from the source, then a maximal set of arc-disjoint shortest paths.
+// It takes O(E min(V^(2/3), E^(1/2))) time, and O(E V^(1/2)) when every
+// vertex but the terminals has a single arc in or out, as in bipartite
+// matching.
+//
+// No capacities are kept. Arc e has a flow bit, set if e carries its unit of
+// flow, and a residual bit, set if e has an unused unit of capacity or its
+// anti-parallel arc carries flow to cancel. The searches only read the
+// residual bits, and skip 64 arcs without residual capacity at once, which
+// saves most of the arc reads in a matching: a matched vertex has one
+// residual arc back to the left side among all its arcs from there. The
+// flow value is the number of paths found. The searches run on the calling
+// thread.
+template <typename T, typename U>
+class UnitCapacityDinic
+{
+public:
+    UnitCapacityDinic(const Graph<T, U> &graph) : graph(graph), unreached(graph.V)
+    {
+        if (!isUnitCapacity(graph))
+        {
+            throw std::logic_error("The unit capacity solver only runs on graphs with capacities of 0 or 1.");
+        }
+    }
+
+    U findMaxFlow()
+    {
+        const std::size_t wordCount = (graph.heads.size() + 63) / 64;
+        residual.assign(wordCount, 0);
+        flow.assign(wordCount, 0);
+        for (T e{0}; e < graph.arcCount(); ++e)
+        {
+            if (graph.capacities[e] > 0)
+                residual[e / 64] |= bit(e);
+        }
+
+        long long paths{0};
+        stopped = false;
+        while (!isCancelled() && findLevelGraph())
+        {
+            ++stats.phases;
+            currents.assign(graph.offsets.begin(), graph.offsets.end() - 1);
+            paths += findBlockingFlow();
+        }
+
+        return static_cast<U>(paths);
+    }
+
+    // Solves as findMaxFlow() until the token expires. The upper bound is
+    // the best cut between the BFS levels of the residual graph left.
+    FlowBounds<U> findFlowBounds(CancellationToken &token)
+    {
+        cancellation = &token;
+        U flow = findMaxFlow();
+        cancellation = nullptr;
+        if (!stopped)
+            return {flow, flow};
+
+        findLevelGraph();
+        return {flow, findBestThresholdCut<U>(graph, levels, graph.V + 1)};
+    }
+
+    const Stats &getStats() const
+    {
+        return stats;
+    }
+
+    // Residual capacities left by the last solve, from the flow bits
+    std::vector<U> getResidualCapacities() const
+    {
+        std::vector<U> capacities(graph.capacities.begin(), graph.capacities.end());
+        for (T e{0}; e < graph.arcCount(); ++e)
+        {
+            if (hasFlow(e))
+            {
+                capacities[e] -= 1;
+                capacities[graph.antiParallel[e]] += 1;
+            }
+        }
+        return capacities;
+    }
+
+private:
+    const Graph<T, U> &graph;
+    Stats stats;
+
+    // Bits of the arcs, 64 arcs per word
+    std::vector<std::uint64_t> residual;
+    std::vector<std::uint64_t> flow;
+
+    // Level of vertices not in the level graph.
+    const T unreached;
+
+    std::vector<T> levels;
+    std::vector<T> currents;
+
+    std::vector<T> queue;
+    std::vector<T> path;
+
+    // Token checked once per phase and per augmenting path, if set
+    CancellationToken *cancellation{nullptr};
+    bool stopped{false};
+
+    bool isCancelled()
+    {
+        stopped = stopped || (cancellation && cancellation->expired());
+        return stopped;
+    }
+
+    static std::uint64_t bit(T e)
+    {
+        return std::uint64_t{1} << (e % 64);
+    }
+
+    static int countTrailingZeros(std::uint64_t word)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(word);
+#else
+        int count{0};
+        for (; !(word & 1); word >>= 1)
+            ++count;
+        return count;
+#endif
+    }
+
+    bool isResidual(T e) const
+    {
+        return residual[e / 64] & bit(e);
+    }
+
+    bool hasFlow(T e) const
+    {
+        return flow[e / 64] & bit(e);
+    }
+
+    // Returns the first arc in [e, end) with residual capacity, or end
+    T nextResidual(T e, T end) const
+    {
+        while (e < end)
+        {
+            std::uint64_t word = residual[e / 64] >> (e % 64);
+            if (word != 0)
+                return std::min<T>(end, e + countTrailingZeros(word));
+            e = (e / 64 + 1) * 64;
+        }
+        return end;
+    }
+
+    // Sends one unit along e. It cancels the flow of the anti-parallel arc r
+    // if there is any, and uses the capacity of e otherwise. Either way r
+    // gets residual capacity, and e keeps some only if it cancelled flow and
+    // has capacity of its own.
+    void push(T e)
+    {
+        T r = graph.antiParallel[e];
+        if (hasFlow(r))
+        {
+            flow[r / 64] &= ~bit(r);
+            if (graph.capacities[e] == 0)
+                residual[e / 64] &= ~bit(e);
+        }
+        else
+        {
+            flow[e / 64] |= bit(e);
+            residual[e / 64] &= ~bit(e);
+        }
+        residual[r / 64] |= bit(r);
+    }
+
+    // Computes the levels by BFS from the source, along residual arcs only,
+    // up to the level of the sink. Returns true if the sink is reached.
+    bool findLevelGraph()
+    {
+        levels.assign(graph.V, unreached);
+        levels[graph.source] = 0;
+        queue.clear();
+        queue.push_back(graph.source);
+
+        for (std::size_t i{0}; i < queue.size() && levels[queue[i]] < levels[graph.sink]; ++i)
+        {
+            const T u = queue[i];
+            const T end = graph.offsets[u + 1];
+            for (T e = nextResidual(graph.offsets[u], end); e < end; e = nextResidual(e + 1, end))
+            {
+                ++stats.arcsScanned;
+                T w = graph.heads[e];
+                if (levels[w] == unreached)
+                {
+                    levels[w] = levels[u] + 1;
+                    queue.push_back(w);
+                }
+            }
+        }
+        return levels[graph.sink] != unreached;
+    }
+
+    // Finds a blocking flow in the level graph with a single DFS, as in
+    // Dinic, one unit per path. Returns the number of paths.
+    long long findBlockingFlow()
+    {
+        long long paths{0};
+        path.clear();
+        T u = graph.source;
+
+        while (true)
+        {
+            if (u == graph.sink)
+            {
+                for (T e : path)
+                    push(e);
+                ++paths;
+                ++stats.augmentingPaths;
+                if (cancellation && cancellation->poll())
+                {
+                    stopped = true;
+                    break;
+                }
+
+                // Retreat to the tail of the first saturated arc. An arc
+                // that cancelled flow may keep residual capacity.
+                std::size_t k{0};
+                while (k < path.size() && isResidual(path[k]))
+                    k++;
+                path.resize(k);
+                u = k == 0 ? graph.source : graph.heads[path[k - 1]];
+                continue;
+            }
+
+            // Advance along the current arc, if it is in the level graph
+            T &e = currents[u];
+            const T end = graph.offsets[u + 1];
+            const T first = e;
+            const T next = levels[u] + 1;
+            e = nextResidual(e, end);
+            while (e < end && levels[graph.heads[e]] != next)
+                e = nextResidual(e + 1, end);
+            stats.arcsScanned += e - first + (e < end);
+
+            if (e < end)
+            {
+                path.push_back(e);
+                u = graph.heads[e];
+            }
+            else
+            {
+                // u is a dead end
+                if (u == graph.source)
+                    break;
+
+                levels[u] = unreached;
+                path.pop_back();
+                u = path.empty() ? graph.source : graph.heads[path.back()];
+            }
+        }
+
+        return paths;
+    }
+};
+
+#endif // UNIT_CAPACITY_H
@@ -3,6 +3,8 @@
 #include <filesystem>
 #include <vector>
 #include "graph_reader.h"
+#include "binary_graph.h"
+#include "graph_builder.h"
 #include <cassert>
 
 class ValidFileTest : public ::testing::Test
@@ -20,22 +22,21 @@ protected:
     }
 };
 
+// Checks the i'th arc leaving vertex u and its anti-parallel arc
 template <typename T, typename U>
-void checkEdge(const std::shared_ptr<Edge<T, U>> &edge, T v, U capacity, T antiParallelV, U antiParallelCapacity)
+void checkEdge(const Graph<T, U> &graph, T u, T i, T v, U capacity, T antiParallelV, U antiParallelCapacity)
 {
-    EXPECT_EQ(edge->v, v);
-    EXPECT_EQ(edge->capacity, capacity);
+    T edge = graph.offsets[u] + i;
+    ASSERT_LT(edge, graph.offsets[u + 1]);
+    EXPECT_EQ(graph.heads[edge], v);
+    EXPECT_EQ(graph.capacities[edge], capacity);
 
-    // Convert the weak_ptr to a shared_ptr
-    auto antiParallelEdge = edge->antiParallel.lock();
-    assert(antiParallelEdge && "Failed to lock antiParallel weak_ptr");
-    EXPECT_EQ(antiParallelEdge->v, antiParallelV);
-    EXPECT_EQ(antiParallelEdge->capacity, antiParallelCapacity);
+    T antiParallelEdge = graph.antiParallel[edge];
+    EXPECT_EQ(graph.heads[antiParallelEdge], antiParallelV);
+    EXPECT_EQ(graph.capacities[antiParallelEdge], antiParallelCapacity);
 
     // Accessing the original edge through two layers of antiParallel
-    auto originalEdge = antiParallelEdge->antiParallel.lock();
-    assert(originalEdge && "Failed to lock original weak_ptr through antiParallel");
-    EXPECT_EQ(originalEdge->v, v);
+    EXPECT_EQ(graph.antiParallel[antiParallelEdge], edge);
 }
 
 // Test a graph that does not have antiparallel edges
@@ -50,11 +51,11 @@ TEST_F(ValidFileTest, ReadGraphFromValidFile)
     EXPECT_EQ(graph.V, 6);
     EXPECT_EQ(graph.E, 9);
 
-    checkEdge(graph.adj_list[0][0], 1, 16, 0, 0);
-    checkEdge(graph.adj_list[0][1], 2, 13, 0, 0);
-    checkEdge(graph.adj_list[4][0], 2, 0, 4, 14);
-    checkEdge(graph.adj_list[4][1], 5, 4, 4, 0);
-    checkEdge(graph.adj_list[4][2], 3, 7, 4, 0);
+    checkEdge(graph, 0, 0, 1, 16, 0, 0);
+    checkEdge(graph, 0, 1, 2, 13, 0, 0);
+    checkEdge(graph, 4, 0, 2, 0, 4, 14);
+    checkEdge(graph, 4, 1, 5, 4, 4, 0);
+    checkEdge(graph, 4, 2, 3, 7, 4, 0);
 }
 
 // Test a graph that has antiparallel edges
@@ -70,11 +71,11 @@ TEST_F(ValidFileTest, ReadGraphFromValidFileAntiparallel)
     EXPECT_EQ(graph.V, 6);
     EXPECT_EQ(graph.E, 10);
 
-    checkEdge(graph.adj_list[0][0], 1, 16, 0, 5);
-    checkEdge(graph.adj_list[0][1], 2, 13, 0, 0);
-    checkEdge(graph.adj_list[4][0], 2, 0, 4, 14);
-    checkEdge(graph.adj_list[4][1], 3, 7, 4, 0);
-    checkEdge(graph.adj_list[4][2], 5, 4, 4, 0);
+    checkEdge(graph, 0, 0, 1, 16, 0, 5);
+    checkEdge(graph, 0, 1, 2, 13, 0, 0);
+    checkEdge(graph, 4, 0, 2, 0, 4, 14);
+    checkEdge(graph, 4, 1, 3, 7, 4, 0);
+    checkEdge(graph, 4, 2, 5, 4, 4, 0);
 }
 
 // The function readGraph<> is a template function, and if we provide its
@@ -143,3 +144,327 @@ TEST_P(InvalidFileTest, TestInvalidFiles)
 {
     EXPECT_THROW(readGraphIntIntEdge(fileStream), std::logic_error);
 }
+
+// Reading a file by path maps it into memory instead of streaming it
+TEST_F(ValidFileTest, ReadGraphFromPath)
+{
+    const std::string path{"../../test/testdata/valid_files/antiparallel.txt"};
+    openFile(path);
+
+    Graph<int, int> streamed = readGraph<int, int, Edge>(fileStream);
+    Graph<int, int> mapped = readGraph<int, int, Edge>(path);
+
+    EXPECT_EQ(mapped.V, streamed.V);
+    EXPECT_EQ(mapped.E, streamed.E);
+    EXPECT_EQ(mapped.source, streamed.source);
+    EXPECT_EQ(mapped.sink, streamed.sink);
+    EXPECT_EQ(mapped.offsets, streamed.offsets);
+    EXPECT_EQ(mapped.heads, streamed.heads);
+    EXPECT_EQ(mapped.capacities, streamed.capacities);
+    EXPECT_EQ(mapped.antiParallel, streamed.antiParallel);
+}
+
+// Returns the message of the error thrown when reading the text
+std::string readErrorMessage(const std::string &text)
+{
+    try
+    {
+        readGraph<int, int, Edge>(text.data(), text.data() + text.size());
+    }
+    catch (const std::logic_error &e)
+    {
+        return e.what();
+    }
+    return "";
+}
+
+TEST(ReadErrorTest, ErrorMessagesGiveTheLine)
+{
+    EXPECT_EQ(readErrorMessage("p max 3 2\nn 1 s\nn 3 t\na 1 2 4\na 1 2 3\n"),
+              "line 5 : Parallel edges not allowed.");
+    EXPECT_EQ(readErrorMessage("p max 3 1\nn 1 s\nn 3 t\nc comment\na 1 4 4\n"),
+              "line 5 : Node numbers not correct.");
+    EXPECT_EQ(readErrorMessage("p max 3 1\nn 1 s\nn 3 t\na 1 2 x\n"),
+              "line 4 : Problem line incorrectly formatted.");
+    EXPECT_EQ(readErrorMessage("p max 3 2\nn 1 s\nn 3 t\na 1 2 4\n"),
+              "Less edges than indicated in the problem line.");
+
+    // The first error in the file is reported, also when it is a parallel edge
+    EXPECT_EQ(readErrorMessage("p max 3 3\nn 1 s\nn 3 t\na 1 2 4\na 1 2 3\nb\n"),
+              "line 5 : Parallel edges not allowed.");
+    EXPECT_EQ(readErrorMessage("p max 3 3\nn 1 s\nn 3 t\na 1 2 4\nb\na 1 2 3\n"),
+              "line 5 : Unknown designator.");
+}
+
+// The graph types are chosen from the problem line and the capacities
+TEST(ProblemProfileTest, ChoosesTypes)
+{
+    auto profile = [](const std::string &contents, unsigned threadCount = 1)
+    {
+        return profileProblem(contents.data(), contents.data() + contents.size(), threadCount, true);
+    };
+
+    ProblemProfile narrow = profile("c comment\np max 3 2\nn 1 s\nn 3 t\na 1 2 4\na 2 3 +5\n");
+    EXPECT_EQ(narrow.vertexCount, 3);
+    EXPECT_EQ(narrow.edgeCount, 2);
+    EXPECT_EQ(narrow.capacitySum, 9u);
+    EXPECT_FALSE(narrow.needsWideIds());
+    EXPECT_FALSE(narrow.needsWideCapacities());
+    EXPECT_FALSE(narrow.needsFloatingCapacities());
+
+    ProblemProfile wide = profile("p max 3 2\nn 1 s\nn 3 t\na 1 2 2000000000\na 2 3 2000000000\n", 2);
+    EXPECT_EQ(wide.capacitySum, 4000000000u);
+    EXPECT_TRUE(wide.needsWideCapacities());
+    EXPECT_FALSE(wide.needsFloatingCapacities());
+
+    EXPECT_TRUE(profile("p max 3 2\nn 1 s\nn 3 t\na 1 2 99999999999999999999\na 2 3 1\n").needsFloatingCapacities());
+    EXPECT_TRUE(profile("p max 3 2\nn 1 s\nn 3 t\na 1 2 0.5\na 2 3 1\n").needsFloatingCapacities());
+    EXPECT_TRUE(profile("p max 3000000000 2\nn 1 s\nn 3 t\n").needsWideIds());
+    EXPECT_TRUE(profile("p max 3 1500000000\nn 1 s\nn 3 t\n").needsWideIds());
+
+    // Lambdas are added to the capacities of the arcs at the terminals
+    ProblemProfile parametric = profile("p max 4 3\nc terminals\nn 1 s\nn 4 t\na 1 2 10\na 2 3 10\na 3 4 10\n", 2);
+    EXPECT_EQ(parametric.terminalArcCount, 2u);
+    parametric.addLambdas({2147483642, -3});
+    EXPECT_TRUE(parametric.needsWideCapacities());
+    EXPECT_FALSE(parametric.needsFloatingCapacities());
+    parametric.addLambdas({0.5});
+    EXPECT_TRUE(parametric.needsFloatingCapacities());
+
+    // Without n lines before the arcs, every arc may be at a terminal
+    EXPECT_EQ(profile("p max 4 3\na 1 2 10\na 2 3 10\na 3 4 10\nn 1 s\nn 4 t\n").terminalArcCount, 3u);
+}
+
+TEST(ReadWideTypesTest, CapacitiesAndIdsBeyond32Bits)
+{
+    std::string contents{"p max 3 2\nn 1 s\nn 3 t\na 1 2 5000000000\na 2 3 0.25\n"};
+    auto graph = readGraph<long long, double, Edge>(contents.data(), contents.data() + contents.size());
+    checkEdge<long long, double>(graph, 0, 0, 1, 5000000000.0, 0, 0.0);
+    checkEdge<long long, double>(graph, 1, 1, 2, 0.25, 1, 0.0);
+
+    EXPECT_EQ(readErrorMessage("p max 3000000000 1\nn 1 s\nn 3 t\na 1 2 4\n"),
+              "line 1 : Too many vertices or edges for 32-bit vertex ids");
+    EXPECT_EQ(readErrorMessage("p max 3 1\nn 1 s\nn 3 t\na 1 2 5000000000\n"),
+              "line 4 : Problem line incorrectly formatted.");
+}
+
+TEST(GridReadTest, ReadsGridProblems)
+{
+    std::string contents{"c 3 x 2 pixels\np grid 3 2 1 4\nt 1 5 0\nt 1 1 0\nt 6 0 7\ne 1 2 4\ne 2 5 3\ne 5 6 2\n"};
+    const char *begin = contents.data();
+    const char *end = begin + contents.size();
+    EXPECT_TRUE(isGridProblem(begin, end));
+
+    auto grid = readGridGraph<int, int>(begin, end);
+    EXPECT_EQ(grid.V, 8);
+    EXPECT_EQ(grid.sourceCapacities[0], 6);
+    EXPECT_EQ(grid.sinkCapacities[5], 7);
+    EXPECT_EQ(grid.capacity(grid.firstArc(0) + grid.findDirection(0, 1)), 4);
+    EXPECT_EQ(grid.capacity(grid.firstArc(1) + grid.findDirection(1, 4)), 3);
+    EXPECT_EQ(grid.capacity(grid.firstArc(1) + grid.findDirection(1, 0)), 0);
+
+    ProblemProfile profile = profileProblem(begin, end);
+    EXPECT_EQ(profile.vertexCount, 8);
+    EXPECT_EQ(profile.capacitySum, 22u);
+    std::string large{"p grid 50000 50000 1 8\n"};
+    EXPECT_TRUE(profileProblem(large.data(), large.data() + large.size()).needsWideIds());
+
+    auto errorMessage = [](const std::string &contents)
+    {
+        try
+        {
+            readGridGraph<int, int>(contents.data(), contents.data() + contents.size());
+        }
+        catch (const std::logic_error &e)
+        {
+            return std::string(e.what());
+        }
+        return std::string();
+    };
+    EXPECT_EQ(errorMessage("p grid 3 2 1 4\ne 1 5 2\n"), "line 2 : Pixels 1 and 5 are not neighbours.");
+    EXPECT_EQ(errorMessage("p grid 3 2 1 4\nt 7 1 1\n"), "line 2 : Pixel numbers not correct.");
+    EXPECT_EQ(errorMessage("p grid 3 2 2 8\n"), "line 1 : Grid sides must be positive, and only grids with 6 neighbours have depth");
+    EXPECT_EQ(errorMessage("t 1 1 1\n"), "line 1 : pixel lines should not appear before problem line.");
+
+    std::string maxProblem{"c p grid\np max 3 2\n"};
+    EXPECT_FALSE(isGridProblem(maxProblem.data(), maxProblem.data() + maxProblem.size()));
+}
+
+// Parsing the arc lines in chunks on several threads gives the same graph
+TEST(ParallelReadTest, SameGraphAsSerial)
+{
+    const std::string path{"../../test/testdata/maxflowInstances/maxflow109V2051E.txt"};
+    if (!std::ifstream(path))
+    {
+        GTEST_SKIP() << "Unable to open file: " << path;
+    }
+
+    Graph<int, int> serial = readGraph<int, int, Edge>(path);
+    for (unsigned threadCount : {2u, 3u, 8u})
+    {
+        Graph<int, int> parallel = readGraph<int, int, Edge>(path, threadCount);
+        EXPECT_EQ(parallel.offsets, serial.offsets);
+        EXPECT_EQ(parallel.heads, serial.heads);
+        EXPECT_EQ(parallel.capacities, serial.capacities);
+        EXPECT_EQ(parallel.antiParallel, serial.antiParallel);
+    }
+}
+
+// Errors are reported for the same line, whichever chunk they are in
+TEST_P(InvalidFileTest, TestInvalidFilesInParallel)
+{
+    std::string serialMessage;
+    try
+    {
+        readGraph<int, int, Edge>(GetParam());
+    }
+    catch (const std::logic_error &e)
+    {
+        serialMessage = e.what();
+    }
+
+    for (unsigned threadCount : {2u, 3u, 8u})
+    {
+        try
+        {
+            readGraph<int, int, Edge>(GetParam(), threadCount);
+            ADD_FAILURE() << "No error with " << threadCount << " threads";
+        }
+        catch (const std::logic_error &e)
+        {
+            EXPECT_EQ(e.what(), serialMessage);
+        }
+    }
+}
+
+// Returns the message of the error thrown when loading and verifying a
+// binary graph
+std::string binaryErrorMessage(const std::string &path)
+{
+    try
+    {
+        readBinaryGraph<int, int>(path, true);
+    }
+    catch (const std::logic_error &e)
+    {
+        return e.what();
+    }
+    return "";
+}
+
+// A graph written in the binary format loads back with the same arrays
+TEST(BinaryGraphTest, RoundTrip)
+{
+    const std::string path{"../../test/testdata/maxflowInstances/maxflow109V2051E.txt"};
+    if (!std::ifstream(path))
+    {
+        GTEST_SKIP() << "Unable to open file: " << path;
+    }
+
+    const std::string binaryPath{"round_trip.bin"};
+    Graph<int, int> text = readGraph<int, int, Edge>(path);
+    writeBinaryGraph(text, binaryPath);
+    ASSERT_TRUE(isBinaryGraph(binaryPath));
+    EXPECT_FALSE(isBinaryGraph(path));
+
+    Graph<int, int> binary = readBinaryGraph<int, int>(binaryPath);
+    EXPECT_EQ(binary.V, text.V);
+    EXPECT_EQ(binary.E, text.E);
+    EXPECT_EQ(binary.source, text.source);
+    EXPECT_EQ(binary.sink, text.sink);
+    EXPECT_EQ(binary.offsets, text.offsets);
+    EXPECT_EQ(binary.heads, text.heads);
+    EXPECT_EQ(binary.capacities, text.capacities);
+    EXPECT_EQ(binary.antiParallel, text.antiParallel);
+
+    // The mapping is copy-on-write, so changed capacities stay out of the file
+    binary.capacities[0] += 1;
+    Graph<int, int> reloaded = readBinaryGraph<int, int>(binaryPath);
+    EXPECT_EQ(reloaded.capacities, text.capacities);
+
+    std::filesystem::remove(binaryPath);
+}
+
+TEST(BinaryGraphTest, RejectsInvalidFiles)
+{
+    const std::string path{"../../test/testdata/valid_files/antiparallel.txt"};
+    if (!std::ifstream(path))
+    {
+        GTEST_SKIP() << "Unable to open file: " << path;
+    }
+
+    const std::string binaryPath{"invalid.bin"};
+    Graph<int, int> graph = readGraph<int, int, Edge>(path);
+    writeBinaryGraph(graph, binaryPath);
+    EXPECT_THROW((readBinaryGraph<int, long long>(binaryPath)), std::logic_error);
+    EXPECT_THROW((readBinaryGraph<int, float>(binaryPath)), std::logic_error);
+
+    // Flip a byte of the capacities
+    {
+        std::fstream file(binaryPath, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(-1, std::ios::end);
+        char last = file.get();
+        file.seekp(-1, std::ios::end);
+        file.put(last ^ 1);
+    }
+    EXPECT_EQ(binaryErrorMessage(binaryPath), binaryPath + ": checksum mismatch, the file is corrupt");
+
+    // Unverified files are trusted
+    EXPECT_NO_THROW((readBinaryGraph<int, int>(binaryPath)));
+
+    std::filesystem::resize_file(binaryPath, std::filesystem::file_size(binaryPath) - 8);
+    EXPECT_EQ(binaryErrorMessage(binaryPath), binaryPath + ": the file size does not match its header");
+
+    EXPECT_EQ(binaryErrorMessage(path), path + ": not a binary graph file");
+    EXPECT_THROW((readBinaryGraph<int, int>("does_not_exist.bin")), std::runtime_error);
+
+    // Arrays that do not form a graph, written with a matching checksum
+    const int head = graph.heads[0];
+    graph.heads[0] = graph.V;
+    writeBinaryGraph(graph, binaryPath);
+    EXPECT_EQ(binaryErrorMessage(binaryPath), binaryPath + ": the arc arrays do not form a graph");
+    graph.heads[0] = head;
+    graph.antiParallel[0] = 1;
+    writeBinaryGraph(graph, binaryPath);
+    EXPECT_EQ(binaryErrorMessage(binaryPath), binaryPath + ": the arc arrays do not form a graph");
+
+    std::filesystem::remove(binaryPath);
+}
+
+template <typename X>
+std::vector<X> toVector(const GraphArray<X> &array)
+{
+    return std::vector<X>(array.begin(), array.end());
+}
+
+// Anti-parallel arcs share an arc pair, in the order the arcs were added
+TEST(GraphBuilderTest, MergesAntiParallelArcs)
+{
+    GraphBuilder<int, int> builder(3, 0, 2);
+    builder.addArc(0, 1, 4);
+    builder.addArc(1, 2, 5);
+    builder.addArc(1, 0, 3);
+    builder.addArc(2, 1, 1);
+    builder.addArc(1, 0, 2);
+    EXPECT_EQ(builder.findParallelArc(), builder.arcCount());
+
+    Graph<int, int> graph = builder.build();
+    EXPECT_EQ(graph.E, 5);
+    EXPECT_EQ(toVector(graph.offsets), (std::vector<int>{0, 1, 3, 4}));
+    EXPECT_EQ(toVector(graph.heads), (std::vector<int>{1, 0, 2, 1}));
+    EXPECT_EQ(toVector(graph.capacities), (std::vector<int>{4, 5, 5, 1}));
+    EXPECT_EQ(toVector(graph.antiParallel), (std::vector<int>{1, 0, 3, 2}));
+}
+
+TEST(GraphBuilderTest, RejectsParallelArcs)
+{
+    GraphBuilder<int, int> builder(3, 0, 2);
+    builder.addArc(0, 1, 4);
+    builder.addArc(1, 2, 5);
+    builder.addArc(1, 0, 3);
+    builder.addArc(0, 1, 1);
+    builder.addArc(1, 2, 5);
+    EXPECT_EQ(builder.findParallelArc(2), 3u);
+    EXPECT_THROW(builder.addArc(0, 2, 1), std::logic_error);
+    EXPECT_THROW(builder.build(), std::logic_error);
+}
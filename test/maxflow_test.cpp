@@ -2,9 +2,45 @@
 #include "edmonds_karp.h"
 #include "dinic.h"
 #include "push_relabel.h"
+#include "push_relabel_parallel.h"
+#include "push_relabel_highest_label.h"
+#include "capacity_scaling.h"
+#include "boykov_kolmogorov.h"
+#include "pseudoflow.h"
+#include "unit_capacity.h"
+#include "min_cut.h"
+#include "parametric.h"
+#include "reorder.h"
+#include "reduce.h"
+#include "bfs.h"
+#include "arc_scan.h"
 #include "graph_reader.h"
+#include "graph_builder.h"
+#include "grid_graph.h"
+#include "solver.h"
+#include "command_line_parser.h"
 #include <vector>
 #include <fstream>
+#include <map>
+#include <thread>
+#include <random>
+#include <numeric>
+
+// Sum of the capacities of the arcs leaving the source side of a cut
+template <typename G>
+int cutCapacity(const G &graph, const std::vector<bool> &sourceSide)
+{
+    int capacity{0};
+    for (int u{0}; u < graph.V; ++u)
+    {
+        for (int e = graph.firstArc(u); e < graph.endArc(u); ++e)
+        {
+            if (sourceSide[u] && !sourceSide[graph.head(e)])
+                capacity += graph.capacity(e);
+        }
+    }
+    return capacity;
+}
 
 class BasicTests : public ::testing::Test
 {
@@ -20,40 +56,46 @@ protected:
     {
 
         // Basic graph
-        graph1 = std::make_unique<Graph<int, int>>(4, 5, 0, 3);
-        graph1->addEdge(0, 1, 3);
-        graph1->addEdge(0, 2, 2);
-        graph1->addEdge(1, 2, 5);
-        graph1->addEdge(1, 3, 2);
-        graph1->addEdge(2, 3, 3);
+        GraphBuilder<int, int> graph1Builder(4, 0, 3);
+        graph1Builder.addArc(0, 1, 3);
+        graph1Builder.addArc(0, 2, 2);
+        graph1Builder.addArc(1, 2, 5);
+        graph1Builder.addArc(1, 3, 2);
+        graph1Builder.addArc(2, 3, 3);
+        graph1 = std::make_unique<Graph<int, int>>(graph1Builder.build());
 
         // Two vertices, zero edges
-        graph2 = std::make_unique<Graph<int, int>>(2, 0, 0, 1);
+        GraphBuilder<int, int> graph2Builder(2, 0, 1);
+        graph2 = std::make_unique<Graph<int, int>>(graph2Builder.build());
 
         // Two vertices, one edge
-        graph3 = std::make_unique<Graph<int, int>>(2, 1, 0, 1);
-        graph3->addEdge(0, 1, 10);
+        GraphBuilder<int, int> graph3Builder(2, 0, 1);
+        graph3Builder.addArc(0, 1, 10);
+        graph3 = std::make_unique<Graph<int, int>>(graph3Builder.build());
 
         // Two vertices, two anti-parallel edges
-        graph4 = std::make_unique<Graph<int, int>>(2, 2, 0, 1);
-        graph4->addEdge(0, 1, 10);
-        graph4->addEdge(1, 0, 20);
+        GraphBuilder<int, int> graph4Builder(2, 0, 1);
+        graph4Builder.addArc(0, 1, 10);
+        graph4Builder.addArc(1, 0, 20);
+        graph4 = std::make_unique<Graph<int, int>>(graph4Builder.build());
 
         // Source and sink are not the first and the last vertices.
-        graph5 = std::make_unique<Graph<int, int>>(4, 5, 3, 0);
-        graph5->addEdge(1, 0, 3);
-        graph5->addEdge(2, 0, 2);
-        graph5->addEdge(2, 1, 5);
-        graph5->addEdge(3, 1, 2);
-        graph5->addEdge(3, 2, 3);
+        GraphBuilder<int, int> graph5Builder(4, 3, 0);
+        graph5Builder.addArc(1, 0, 3);
+        graph5Builder.addArc(2, 0, 2);
+        graph5Builder.addArc(2, 1, 5);
+        graph5Builder.addArc(3, 1, 2);
+        graph5Builder.addArc(3, 2, 3);
+        graph5 = std::make_unique<Graph<int, int>>(graph5Builder.build());
 
         // No path from source to sink.
-        graph6 = std::make_unique<Graph<int, int>>(4, 3, 0, 3);
-        graph6->addEdge(0, 1, 3);
-        graph6->addEdge(0, 2, 2);
-        graph6->addEdge(1, 2, 5);
-        graph6->addEdge(3, 1, 2);
-        graph6->addEdge(3, 2, 3);
+        GraphBuilder<int, int> graph6Builder(4, 0, 3);
+        graph6Builder.addArc(0, 1, 3);
+        graph6Builder.addArc(0, 2, 2);
+        graph6Builder.addArc(1, 2, 5);
+        graph6Builder.addArc(3, 1, 2);
+        graph6Builder.addArc(3, 2, 3);
+        graph6 = std::make_unique<Graph<int, int>>(graph6Builder.build());
     }
 };
 
@@ -123,32 +165,887 @@ TEST_F(BasicTests, PushRelabelTests)
     EXPECT_EQ(pushRelabel6.findMaxFlow(), 0);
 }
 
+TEST_F(BasicTests, PushRelabelUpdateTests)
+{
+    PushRelabel<int, int> pushRelabel(*graph1);
+    EXPECT_THROW(pushRelabel.updateCapacities({{0, 1}}), std::logic_error);
+    EXPECT_EQ(pushRelabel.findMaxFlow(), 5);
+
+    // Flow on 1->3 is rerouted where it can be, and taken back otherwise
+    EXPECT_EQ(pushRelabel.updateCapacities({{graph1->findArc(1, 3), 0}}), 3);
+    EXPECT_EQ(pushRelabel.updateCapacities({{graph1->findArc(2, 3), 10}}), 5);
+    EXPECT_EQ(pushRelabel.updateCapacities({{graph1->findArc(0, 1), 10}, {graph1->findArc(1, 3), 1}}), 8);
+    EXPECT_EQ(findMinCut(*graph1, pushRelabel.getResidualCapacities()), std::vector<bool>({true, true, false, false}));
+
+    EXPECT_THROW(pushRelabel.updateCapacities({{graph1->findArc(0, 1), -1}}), std::logic_error);
+
+    // Solving again starts from the capacities of the graph
+    EXPECT_EQ(pushRelabel.findMaxFlow(), 5);
+}
+
+TEST_F(BasicTests, ParallelPushRelabelTests)
+{
+
+    ParallelPushRelabel<int, int> parallelPushRelabel1(*graph1, 2);
+    EXPECT_EQ(parallelPushRelabel1.findMaxFlow(), 5);
+
+    ParallelPushRelabel<int, int> parallelPushRelabel2(*graph2, 2);
+    EXPECT_EQ(parallelPushRelabel2.findMaxFlow(), 0);
+
+    ParallelPushRelabel<int, int> parallelPushRelabel3(*graph3, 2);
+    EXPECT_EQ(parallelPushRelabel3.findMaxFlow(), 10);
+
+    ParallelPushRelabel<int, int> parallelPushRelabel4(*graph4, 2);
+    EXPECT_EQ(parallelPushRelabel4.findMaxFlow(), 10);
+
+    ParallelPushRelabel<int, int> parallelPushRelabel5(*graph5, 2);
+    EXPECT_EQ(parallelPushRelabel5.findMaxFlow(), 5);
+
+    ParallelPushRelabel<int, int> parallelPushRelabel6(*graph6, 2);
+    EXPECT_EQ(parallelPushRelabel6.findMaxFlow(), 0);
+}
+
+TEST_F(BasicTests, HighestLabelPushRelabelTests)
+{
+
+    HighestLabelPushRelabel<int, int> highestLabel1(*graph1);
+    EXPECT_EQ(highestLabel1.findMaxFlow(), 5);
+
+    HighestLabelPushRelabel<int, int> highestLabel2(*graph2);
+    EXPECT_EQ(highestLabel2.findMaxFlow(), 0);
+
+    HighestLabelPushRelabel<int, int> highestLabel3(*graph3);
+    EXPECT_EQ(highestLabel3.findMaxFlow(), 10);
+
+    HighestLabelPushRelabel<int, int> highestLabel4(*graph4);
+    EXPECT_EQ(highestLabel4.findMaxFlow(), 10);
+
+    HighestLabelPushRelabel<int, int> highestLabel5(*graph5);
+    EXPECT_EQ(highestLabel5.findMaxFlow(), 5);
+
+    HighestLabelPushRelabel<int, int> highestLabel6(*graph6);
+    EXPECT_EQ(highestLabel6.findMaxFlow(), 0);
+}
+
+TEST_F(BasicTests, HighestLabelPushRelabelPhaseOneTests)
+{
+
+    HighestLabelPushRelabel<int, int> highestLabel1(*graph1);
+    EXPECT_EQ(highestLabel1.findMaxPreflow(), 5);
+    EXPECT_EQ(findMinCut(*graph1, highestLabel1.getResidualCapacities()), std::vector<bool>({true, true, true, false}));
+
+    HighestLabelPushRelabel<int, int> highestLabel4(*graph4);
+    EXPECT_EQ(highestLabel4.findMaxPreflow(), 10);
+    EXPECT_EQ(findMinCut(*graph4, highestLabel4.getResidualCapacities()), std::vector<bool>({true, false}));
+
+    HighestLabelPushRelabel<int, int> highestLabel6(*graph6);
+    EXPECT_EQ(highestLabel6.findMaxPreflow(), 0);
+    EXPECT_EQ(findMinCut(*graph6, highestLabel6.getResidualCapacities()), std::vector<bool>({true, true, true, false}));
+
+    // Phase two keeps the minimum cut
+    highestLabel1.convertToFlow();
+    EXPECT_EQ(findMinCut(*graph1, highestLabel1.getResidualCapacities()), std::vector<bool>({true, true, true, false}));
+}
+
+TEST_F(BasicTests, CapacityScalingTests)
+{
+
+    CapacityScaling<int, int> capacityScaling1(*graph1);
+    EXPECT_EQ(capacityScaling1.findMaxFlow(), 5);
+
+    CapacityScaling<int, int> capacityScaling2(*graph2);
+    EXPECT_EQ(capacityScaling2.findMaxFlow(), 0);
+
+    CapacityScaling<int, int> capacityScaling3(*graph3);
+    EXPECT_EQ(capacityScaling3.findMaxFlow(), 10);
+
+    CapacityScaling<int, int> capacityScaling4(*graph4);
+    EXPECT_EQ(capacityScaling4.findMaxFlow(), 10);
+
+    CapacityScaling<int, int> capacityScaling5(*graph5);
+    EXPECT_EQ(capacityScaling5.findMaxFlow(), 5);
+
+    CapacityScaling<int, int> capacityScaling6(*graph6);
+    EXPECT_EQ(capacityScaling6.findMaxFlow(), 0);
+}
+
+TEST_F(BasicTests, BoykovKolmogorovTests)
+{
+
+    BoykovKolmogorov<int, int> boykovKolmogorov1(*graph1);
+    EXPECT_EQ(boykovKolmogorov1.findMaxFlow(), 5);
+
+    BoykovKolmogorov<int, int> boykovKolmogorov2(*graph2);
+    EXPECT_EQ(boykovKolmogorov2.findMaxFlow(), 0);
+
+    BoykovKolmogorov<int, int> boykovKolmogorov3(*graph3);
+    EXPECT_EQ(boykovKolmogorov3.findMaxFlow(), 10);
+
+    BoykovKolmogorov<int, int> boykovKolmogorov4(*graph4);
+    EXPECT_EQ(boykovKolmogorov4.findMaxFlow(), 10);
+
+    BoykovKolmogorov<int, int> boykovKolmogorov5(*graph5);
+    EXPECT_EQ(boykovKolmogorov5.findMaxFlow(), 5);
+
+    BoykovKolmogorov<int, int> boykovKolmogorov6(*graph6);
+    EXPECT_EQ(boykovKolmogorov6.findMaxFlow(), 0);
+}
+
+// Fixed pseudo-random sequence for building test graphs, a linear
+// congruential generator, so the graphs are the same with every standard library
+class TestSequence
+{
+public:
+    explicit TestSequence(unsigned seed) : state(seed) {}
+
+    // Returns the next number in [0, range)
+    int next(int range)
+    {
+        state = state * 1103515245 + 12345;
+        return static_cast<int>((state >> 16) % range);
+    }
+
+private:
+    unsigned state;
+};
+
+// 4-connected W x H grid with terminal arcs from the source and to the sink,
+// as in image segmentation. Capacities come from a fixed pseudo-random sequence.
+GridGraph<int, int> makeImplicitGrid(int width, int height)
+{
+    GridGraph<int, int> grid(width, height, 1, 4);
+    TestSequence sequence(12345);
+    for (int p{0}; p < grid.pixels; ++p)
+    {
+        grid.sourceCapacities[p] = sequence.next(20);
+        grid.sinkCapacities[p] = sequence.next(20);
+        if (p % width + 1 < width)
+            grid.setNeighbourCapacity(p, 0, sequence.next(10));
+        if (p / width + 1 < height)
+            grid.setNeighbourCapacity(p, 2, sequence.next(10));
+    }
+    return grid;
+}
+
+// The grid of makeImplicitGrid as a Graph, built arc by arc
+std::unique_ptr<Graph<int, int>> makeGridGraph(int width, int height)
+{
+    const GridGraph<int, int> grid = makeImplicitGrid(width, height);
+    GraphBuilder<int, int> builder(grid.V, grid.source, grid.sink);
+    for (int p{0}; p < grid.pixels; ++p)
+    {
+        builder.addArc(grid.source, p, grid.sourceCapacities[p]);
+        builder.addArc(p, grid.sink, grid.sinkCapacities[p]);
+        if (grid.hasNeighbour(p, 0))
+            builder.addArc(p, p + 1, grid.neighbourCapacities[p]);
+        if (grid.hasNeighbour(p, 2))
+            builder.addArc(p, p + width, grid.neighbourCapacities[2 * grid.pixels + p]);
+    }
+    return std::make_unique<Graph<int, int>>(builder.build());
+}
+
+TEST(GridGraphTest, BoykovKolmogorovTests)
+{
+    auto reference = makeGridGraph(30, 20);
+    Dinic<int, int> dinic(*reference);
+    int expectedMaxFlow = dinic.findMaxFlow();
+
+    auto graph = makeGridGraph(30, 20);
+    BoykovKolmogorov<int, int> boykovKolmogorov(*graph);
+    EXPECT_EQ(boykovKolmogorov.findMaxFlow(), expectedMaxFlow);
+}
+
+// Batches of random capacity changes give the max flow of a new solve
+TEST(PushRelabelUpdateTest, BatchesOfChanges)
+{
+    auto graph = makeGridGraph(30, 20);
+    Graph<int, int> changed = *graph;
+    PushRelabel<int, int> pushRelabel(*graph);
+    pushRelabel.findMaxFlow();
+    TestSequence sequence(54321);
+
+    for (int batch{0}; batch < 10; ++batch)
+    {
+        std::vector<CapacityChange<int, int>> changes;
+        for (int i{0}; i < 50; ++i)
+        {
+            int arc = sequence.next(changed.heads.size());
+            int capacity = sequence.next(20);
+            changes.push_back({arc, capacity});
+            changed.capacities[arc] = capacity;
+        }
+
+        Dinic<int, int> dinic(changed);
+        EXPECT_EQ(pushRelabel.updateCapacities(changes), dinic.findMaxFlow());
+    }
+}
+
+// Every lambda gives the max flow of a solve with the capacities at lambda
+TEST(ParametricTest, NestedCutsOnGrid)
+{
+    auto graph = makeGridGraph(30, 20);
+    std::vector<int> lambdas{8, -4, 0, 3, 12, 30};
+    auto results = solveParametric(*graph, lambdas);
+    ASSERT_EQ(results.size(), lambdas.size());
+
+    std::vector<bool> previousSourceSide(graph->V, false);
+    for (const auto &result : results)
+    {
+        Graph<int, int> atLambda = *graph;
+        for (int u{0}; u < graph->V; ++u)
+        {
+            for (int e = graph->offsets[u]; e < graph->offsets[u + 1]; ++e)
+            {
+                if (u == graph->source)
+                    atLambda.capacities[e] = std::max(graph->capacities[e] + result.lambda, 0);
+                else if (graph->heads[e] == graph->sink)
+                    atLambda.capacities[e] = std::max(graph->capacities[e] - result.lambda, 0);
+            }
+        }
+
+        Dinic<int, int> dinic(atLambda);
+        EXPECT_EQ(result.maxflow, dinic.findMaxFlow());
+        EXPECT_EQ(cutCapacity(atLambda, result.sourceSide), result.maxflow);
+
+        // The cuts are nested
+        for (int v{0}; v < graph->V; ++v)
+            EXPECT_TRUE(!previousSourceSide[v] || result.sourceSide[v]);
+        previousSourceSide = result.sourceSide;
+    }
+    EXPECT_EQ(results.front().lambda, -4);
+    EXPECT_EQ(results.back().maxflow, 0);
+
+    // Lambdas that fit in U, but not added to every terminal arc
+    EXPECT_THROW(solveParametric(*graph, std::vector<int>{0, std::numeric_limits<int>::max() - 5}), std::invalid_argument);
+    EXPECT_THROW(solveParametric(*graph, std::vector<int>{std::numeric_limits<int>::min()}), std::invalid_argument);
+}
+
+TEST(ReorderTest, RenumberedGrid)
+{
+    auto graph = makeGridGraph(30, 20);
+    Dinic<int, int> dinic(*graph);
+    int maxflow = dinic.findMaxFlow();
+
+    for (VertexOrder order : {VertexOrder::none, VertexOrder::bfs, VertexOrder::rcm, VertexOrder::degree})
+    {
+        VertexReordering<int> reordering;
+        Graph<int, int> reordered = reorderVertices(*graph, order, reordering, 2);
+        ASSERT_EQ(reordered.V, graph->V);
+        ASSERT_EQ(reordered.heads.size(), graph->heads.size());
+        EXPECT_EQ(reordering.order[reordered.source], graph->source);
+        EXPECT_EQ(reordering.order[reordered.sink], graph->sink);
+
+        // Every arc keeps its ends, capacity and anti-parallel arc
+        for (int u{0}; u < reordered.V; ++u)
+        {
+            for (int e = reordered.offsets[u]; e < reordered.offsets[u + 1]; ++e)
+            {
+                int original = reordering.arcs[e];
+                EXPECT_EQ(graph->heads[original], reordering.order[reordered.heads[e]]);
+                EXPECT_EQ(graph->capacities[original], reordered.capacities[e]);
+                EXPECT_EQ(graph->antiParallel[original], reordering.arcs[reordered.antiParallel[e]]);
+                EXPECT_TRUE(e == reordered.offsets[u] || reordered.heads[e - 1] <= reordered.heads[e]);
+            }
+        }
+
+        HighestLabelPushRelabel<int, int> highestLabel(reordered);
+        EXPECT_EQ(highestLabel.findMaxFlow(), maxflow);
+
+        // The cut and the residual capacities map back to a minimum cut of the graph
+        auto sourceSide = reordering.toOriginalVertices(findMinCut(reordered, highestLabel.getResidualCapacities()));
+        EXPECT_EQ(cutCapacity(*graph, sourceSide), maxflow);
+        EXPECT_EQ(findMinCut(*graph, reordering.toOriginalArcs(highestLabel.getResidualCapacities())), sourceSide);
+    }
+
+    VertexReordering<int> reordering;
+    EXPECT_THROW(renumberVertices(*graph, std::vector<int>(graph->V, 0), reordering), std::logic_error);
+
+    // Ids outside the graph, in an order that is otherwise a permutation
+    std::vector<int> order(graph->V);
+    std::iota(order.begin(), order.end(), 0);
+    order.back() = graph->V;
+    EXPECT_THROW(renumberVertices(*graph, order, reordering), std::logic_error);
+    order.back() = -1;
+    EXPECT_THROW(renumberVertices(*graph, order, reordering), std::logic_error);
+}
+
+// Checks that the residual capacities describe a flow of the given value
+void expectFlow(const Graph<int, int> &graph, const std::vector<int> &capacities, int value)
+{
+    for (int u{0}; u < graph.V; ++u)
+    {
+        int outflow{0};
+        for (int e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e)
+        {
+            EXPECT_GE(capacities[e], 0);
+            outflow += graph.capacities[e] - capacities[e];
+        }
+        if (u == graph.source)
+            EXPECT_EQ(outflow, value);
+        else if (u == graph.sink)
+            EXPECT_EQ(outflow, -value);
+        else
+            EXPECT_EQ(outflow, 0);
+    }
+}
+
+// Distances by a plain queue BFS along arcs with capacity
+std::vector<int> queueDistances(const Graph<int, int> &graph, int root)
+{
+    std::vector<int> distances(graph.V, graph.V);
+    std::vector<int> queue{root};
+    distances[root] = 0;
+    for (std::size_t i{0}; i < queue.size(); ++i)
+    {
+        int u = queue[i];
+        for (int e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e)
+        {
+            if (graph.capacities[e] > 0 && distances[graph.heads[e]] == graph.V)
+            {
+                distances[graph.heads[e]] = distances[u] + 1;
+                queue.push_back(graph.heads[e]);
+            }
+        }
+    }
+    return distances;
+}
+
+TEST(FrontierBFSTest, GridAndLayeredGraphs)
+{
+    // Large enough that levels are expanded bottom-up on several threads
+    auto graph = makeGridGraph(200, 150);
+    auto open = [&graph](int e)
+    {
+        return graph->capacities[e] > 0;
+    };
+    std::vector<int> expected = queueDistances(*graph, graph->source);
+
+    for (unsigned threadCount : {1u, 4u})
+    {
+        FrontierBFS<int> bfs(threadCount);
+        std::vector<int> distances;
+        std::vector<int> parents;
+        bfs.search(*graph, graph->source, open, distances, &parents);
+        EXPECT_EQ(distances, expected);
+        EXPECT_EQ(bfs.getOrder().size(), static_cast<std::size_t>(std::count_if(expected.begin(), expected.end(), [&graph](int d)
+                                                                                   { return d < graph->V; })));
+
+        // Parent arcs lead one level up
+        for (int v{0}; v < graph->V; ++v)
+        {
+            if (v == graph->source || distances[v] == graph->V)
+                continue;
+            int e = parents[v];
+            EXPECT_EQ(graph->heads[e], v);
+            EXPECT_GT(graph->capacities[e], 0);
+            EXPECT_EQ(distances[graph->heads[graph->antiParallel[e]]], distances[v] - 1);
+        }
+
+        // Stopping at the sink, and never visiting an excluded vertex
+        bfs.search(*graph, graph->source, open, distances, nullptr, graph->sink, 0);
+        EXPECT_EQ(distances[graph->sink], expected[graph->sink]);
+        EXPECT_EQ(distances[0], graph->V);
+    }
+
+    // Two layers of 1000 vertices with 300 arcs between them from every
+    // vertex, a level large enough to be split between four threads
+    const int layer{1000};
+    GraphBuilder<int, int> layeredBuilder(2 * layer + 2, 2 * layer, 2 * layer + 1);
+    for (int u{0}; u < layer; ++u)
+    {
+        layeredBuilder.addArc(2 * layer, u, 1);
+        for (int k{0}; k < 300; ++k)
+            layeredBuilder.addArc(u, layer + (u + 3 * k) % layer, 1);
+        layeredBuilder.addArc(layer + u, 2 * layer + 1, 1);
+    }
+    Graph<int, int> layered = layeredBuilder.build();
+    auto layeredOpen = [&layered](int e)
+    {
+        return layered.capacities[e] > 0;
+    };
+    FrontierBFS<int> layeredBFS(4);
+    std::vector<int> layeredDistances;
+    layeredBFS.search(layered, layered.source, layeredOpen, layeredDistances);
+    EXPECT_EQ(layeredDistances, queueDistances(layered, layered.source));
+
+    Dinic<int, int> dinic(*graph);
+    int maxflow = dinic.findMaxFlow();
+    Dinic<int, int> parallelDinic(*graph, 4);
+    EXPECT_EQ(parallelDinic.findMaxFlow(), maxflow);
+    HighestLabelPushRelabel<int, int> highestLabel(*graph, 4);
+    EXPECT_EQ(highestLabel.findMaxFlow(), maxflow);
+    auto smallGraph = makeGridGraph(40, 30);
+    EdmondsKarp<int, int> edmondsKarp(*smallGraph, 4);
+    Dinic<int, int> smallDinic(*smallGraph);
+    EXPECT_EQ(edmondsKarp.findMaxFlow(), smallDinic.findMaxFlow());
+}
+
+TEST(GridGraphTest, ImplicitGridTests)
+{
+    // The same grid, implicit and built as a Graph
+    auto reference = makeGridGraph(30, 20);
+    GridGraph<int, int> grid = makeImplicitGrid(30, 20);
+    EXPECT_THROW(grid.setNeighbourCapacity(29, 0, 1), std::logic_error);
+
+    Dinic<int, int> referenceDinic(*reference);
+    int maxflow = referenceDinic.findMaxFlow();
+    Dinic<int, int, GridGraph<int, int>> dinic(grid);
+    EXPECT_EQ(dinic.findMaxFlow(), maxflow);
+    BoykovKolmogorov<int, int, GridGraph<int, int>> boykovKolmogorov(grid);
+    EXPECT_EQ(boykovKolmogorov.findMaxFlow(), maxflow);
+    EXPECT_EQ(cutCapacity(grid, findMinCut(grid, boykovKolmogorov.getResidualCapacities())), maxflow);
+
+    // Random 8 and 6 neighbour grids, against their conversion to a Graph
+    std::mt19937 random(7);
+    for (auto sides : {std::vector<int>{17, 13, 1, 8}, std::vector<int>{9, 7, 5, 6}, std::vector<int>{1, 12, 1, 8}})
+    {
+        GridGraph<int, int> other(sides[0], sides[1], sides[2], sides[3]);
+        for (int p{0}; p < other.pixels; ++p)
+        {
+            other.sourceCapacities[p] = random() % 3 == 0 ? random() % 20 : 0;
+            other.sinkCapacities[p] = random() % 3 == 0 ? random() % 20 : 0;
+            for (int d{0}; d < other.neighbours; ++d)
+            {
+                if (other.hasNeighbour(p, d))
+                    other.setNeighbourCapacity(p, d, random() % 10);
+            }
+        }
+
+        // Arcs pair up, including the ones that leave the grid
+        for (int u{0}; u < other.V; ++u)
+        {
+            for (int e = other.firstArc(u); e < other.endArc(u); ++e)
+            {
+                EXPECT_EQ(other.reverse(other.reverse(e)), e);
+                EXPECT_EQ(other.head(other.reverse(e)), u);
+            }
+        }
+
+        const Graph<int, int> graph = gridToGraph(other);
+        Dinic<int, int> graphDinic(graph);
+        int expected = graphDinic.findMaxFlow();
+        Dinic<int, int, GridGraph<int, int>> gridDinic(other, 4);
+        EXPECT_EQ(gridDinic.findMaxFlow(), expected);
+        BoykovKolmogorov<int, int, GridGraph<int, int>> gridBoykovKolmogorov(other);
+        EXPECT_EQ(gridBoykovKolmogorov.findMaxFlow(), expected);
+        EXPECT_EQ(cutCapacity(other, findMinCut(other, gridDinic.getResidualCapacities())), expected);
+    }
+}
+
+TEST(ReduceTest, ReductionsAndLift)
+{
+    // Vertex 1 has 3 units of terminal capacity to cancel, after which
+    // 1 -> 2 -> 3 and 4 -> 5 are chains from the source to the sink. One of
+    // them keeps its first vertex. 6 can not reach the sink and 8 can not be
+    // reached.
+    GraphBuilder<int, int> builder(9, 0, 7);
+    builder.addArc(0, 1, 5);
+    builder.addArc(1, 7, 3);
+    builder.addArc(1, 2, 4);
+    builder.addArc(2, 3, 2);
+    builder.addArc(3, 7, 6);
+    builder.addArc(0, 4, 7);
+    builder.addArc(4, 5, 1);
+    builder.addArc(5, 7, 9);
+    builder.addArc(0, 6, 3);
+    builder.addArc(8, 7, 4);
+    const Graph<int, int> graph = builder.build();
+
+    GraphReduction<int, int> reduction;
+    const Graph<int, int> reduced = reduceGraph(graph, reduction);
+    EXPECT_EQ(reduced.V, 3);
+    EXPECT_EQ(reduction.vertices.front(), 0);
+    EXPECT_EQ(reduction.vertices.back(), 7);
+    EXPECT_EQ(reduction.flowOffset, 3);
+
+    Dinic<int, int> dinic(reduced);
+    EXPECT_EQ(dinic.findMaxFlow() + reduction.flowOffset, 6);
+
+    expectFlow(graph, reduction.liftResidualCapacities(graph, reduced, dinic.getResidualCapacities()), 6);
+    auto sourceSide = reduction.liftMinCut(graph, reduced, dinic.getResidualCapacities());
+    EXPECT_EQ(cutCapacity(graph, sourceSide), 6);
+}
+
+TEST(ReduceTest, GridGraph)
+{
+    auto graph = makeGridGraph(30, 20);
+    Dinic<int, int> dinic(*graph);
+    int maxflow = dinic.findMaxFlow();
+
+    GraphReduction<int, int> reduction;
+    const Graph<int, int> reduced = reduceGraph(*graph, reduction);
+    EXPECT_LT(reduced.heads.size(), graph->heads.size());
+
+    HighestLabelPushRelabel<int, int> highestLabel(reduced);
+    EXPECT_EQ(highestLabel.findMaxFlow() + reduction.flowOffset, maxflow);
+    Pseudoflow<int, int> pseudoflow(reduced);
+    EXPECT_EQ(pseudoflow.findMaxFlow() + reduction.flowOffset, maxflow);
+
+    expectFlow(*graph, reduction.liftResidualCapacities(*graph, reduced, highestLabel.getResidualCapacities()), maxflow);
+    EXPECT_EQ(cutCapacity(*graph, reduction.liftMinCut(*graph, reduced, highestLabel.getResidualCapacities())), maxflow);
+}
+
+TEST_F(BasicTests, PseudoflowTests)
+{
+
+    Pseudoflow<int, int> pseudoflow1(*graph1);
+    EXPECT_EQ(pseudoflow1.findMaxFlow(), 5);
+
+    Pseudoflow<int, int> pseudoflow2(*graph2);
+    EXPECT_EQ(pseudoflow2.findMaxFlow(), 0);
+
+    Pseudoflow<int, int> pseudoflow3(*graph3);
+    EXPECT_EQ(pseudoflow3.findMaxFlow(), 10);
+
+    Pseudoflow<int, int> pseudoflow4(*graph4);
+    EXPECT_EQ(pseudoflow4.findMaxFlow(), 10);
+
+    Pseudoflow<int, int> pseudoflow5(*graph5);
+    EXPECT_EQ(pseudoflow5.findMaxFlow(), 5);
+
+    Pseudoflow<int, int> pseudoflow6(*graph6);
+    EXPECT_EQ(pseudoflow6.findMaxFlow(), 0);
+
+    // No vertex is lifted when every excess reaches a deficit
+    EXPECT_EQ(pseudoflow1.minCut(), std::vector<bool>({true, false, false, false}));
+    EXPECT_EQ(pseudoflow6.minCut(), std::vector<bool>({true, true, true, false}));
+}
+
+TEST_F(BasicTests, UnitCapacityTests)
+{
+    EXPECT_THROW((UnitCapacityDinic<int, int>(*graph1)), std::logic_error);
+    EXPECT_FALSE(isUnitCapacity(*graph3));
+
+    UnitCapacityDinic<int, int> unit2(*graph2);
+    EXPECT_EQ(unit2.findMaxFlow(), 0);
+
+    // Bipartite matching, with anti-parallel arcs of capacity 1 both ways
+    // between some right vertices, which may carry flow either way
+    std::mt19937 random(5);
+    for (int side : {5, 7, 40, 150})
+    {
+        GraphBuilder<int, int> builder(2 * side + 2, 2 * side, 2 * side + 1);
+        for (int i{0}; i < side; ++i)
+        {
+            builder.addArc(2 * side, i, 1);
+            builder.addArc(side + i, 2 * side + 1, 1);
+            for (int k{0}; k < 3; ++k)
+                builder.addArc(i, side + (i + k * 2) % side, 1);
+            if (i % 4 == 0)
+            {
+                builder.addArc(side + i, side + (i + 1) % side, 1);
+                builder.addArc(side + (i + 1) % side, side + i, 1);
+            }
+        }
+        const Graph<int, int> graph = builder.build();
+        EXPECT_TRUE(isUnitCapacity(graph));
+
+        Dinic<int, int> dinic(graph);
+        int expected = dinic.findMaxFlow();
+        UnitCapacityDinic<int, int> unit(graph);
+        EXPECT_EQ(unit.findMaxFlow(), expected);
+        EXPECT_EQ(cutCapacity(graph, findMinCut(graph, unit.getResidualCapacities())), expected);
+    }
+
+    // Random unit networks, with paths long enough for several phases
+    for (int round{0}; round < 20; ++round)
+    {
+        const int V{60};
+        GraphBuilder<int, int> builder(V, 0, V - 1);
+        for (int u{0}; u < V; ++u)
+        {
+            for (int v{0}; v < V; ++v)
+            {
+                if (u != v && random() % 10 == 0)
+                    builder.addArc(u, v, 1);
+            }
+        }
+        const Graph<int, int> graph = builder.build();
+        Dinic<int, int> dinic(graph);
+        UnitCapacityDinic<int, int> unit(graph);
+        int maxflow = unit.findMaxFlow();
+        EXPECT_EQ(maxflow, dinic.findMaxFlow());
+        EXPECT_EQ(cutCapacity(graph, findMinCut(graph, unit.getResidualCapacities())), maxflow);
+    }
+
+    // "auto" picks unit for unit graphs only, and "dinic" always runs Dinic
+    using AlgorithmEnums::Algorithm;
+    EXPECT_EQ(AlgorithmEnums::stringToEnum("auto"), Algorithm::automatic);
+    EXPECT_EQ(resolveAlgorithm(Algorithm::automatic, *graph2), Algorithm::unit);
+    EXPECT_EQ(resolveAlgorithm(Algorithm::automatic, *graph1), Algorithm::dinic);
+    EXPECT_EQ(resolveAlgorithm(Algorithm::dinic, *graph2), Algorithm::dinic);
+    EXPECT_EQ(findMaxFlow(Algorithm::automatic, *graph1), findMaxFlow(Algorithm::dinic, *graph1));
+    EXPECT_EQ(findMaxFlow(Algorithm::automatic, *graph2), 0);
+}
+
+// Bounds from stopped solves hold the max flow value, and are exact when
+// the token does not expire
+TEST_F(BasicTests, FlowBoundsTests)
+{
+    std::mt19937 random(6);
+    for (int round{0}; round < 10; ++round)
+    {
+        const int V{50};
+        GraphBuilder<int, int> builder(V, 0, V - 1);
+        for (int u{0}; u < V; ++u)
+        {
+            for (int v{0}; v < V; ++v)
+            {
+                if (u != v && random() % 8 == 0)
+                    builder.addArc(u, v, round % 2 == 0 ? 1 : 1 + random() % 20);
+            }
+        }
+        const Graph<int, int> graph = builder.build();
+        Dinic<int, int> reference(graph);
+        const int maxflow = reference.findMaxFlow();
+
+        auto check = [&](auto &solver)
+        {
+            CancellationToken cancelled;
+            cancelled.cancel();
+            FlowBounds<int> bounds = solver.findFlowBounds(cancelled);
+            EXPECT_LE(bounds.lower, maxflow);
+            EXPECT_GE(bounds.upper, maxflow);
+
+            CancellationToken token;
+            bounds = solver.findFlowBounds(token);
+            EXPECT_EQ(bounds.lower, maxflow);
+            EXPECT_EQ(bounds.upper, maxflow);
+
+            // A timed token that has already expired
+            CancellationToken expired(std::chrono::steady_clock::duration::zero());
+            bounds = solver.findFlowBounds(expired);
+            EXPECT_LE(bounds.lower, maxflow);
+            EXPECT_GE(bounds.upper, maxflow);
+
+            // A limit too long for the clock is no limit
+            CancellationToken unlimited(secondsToDuration(1e10));
+            bounds = solver.findFlowBounds(unlimited);
+            EXPECT_EQ(bounds.lower, maxflow);
+            EXPECT_EQ(bounds.upper, maxflow);
+
+            EXPECT_EQ(solver.findMaxFlow(), maxflow);
+        };
+
+        EdmondsKarp<int, int> ek(graph);
+        check(ek);
+        Dinic<int, int> dinic(graph);
+        check(dinic);
+        PushRelabel<int, int> pr(graph);
+        check(pr);
+        HighestLabelPushRelabel<int, int> hipr(graph);
+        check(hipr);
+        if (isUnitCapacity(graph))
+        {
+            UnitCapacityDinic<int, int> unit(graph);
+            check(unit);
+        }
+    }
+
+    // Limits of about 292 years or more saturate, and their deadlines do not
+    // overflow the clock
+    const auto longest = std::chrono::steady_clock::duration::max();
+    EXPECT_EQ(secondsToDuration(0.5), std::chrono::milliseconds(500));
+    EXPECT_EQ(secondsToDuration(1e10), longest);
+    EXPECT_EQ(secondsToDuration(1e300), longest);
+    EXPECT_EQ(secondsToDuration(std::numeric_limits<double>::infinity()), longest);
+    CancellationToken unlimited(longest);
+    EXPECT_FALSE(unlimited.expired());
+    CancellationToken nearlyUnlimited(longest - std::chrono::hours(24 * 365));
+    EXPECT_FALSE(nearlyUnlimited.expired());
+
+    // The threshold cuts of the BFS levels of graph1 are {0} and {0, 1, 2},
+    // of capacity 5 both
+    EXPECT_EQ(findBestThresholdCut<int>(*graph1, std::vector<int>{0, 1, 1, 2}, 5), 5);
+    // The sink of graph6 is not reached, and {0, 1, 2} has no arc out
+    EXPECT_EQ(findBestThresholdCut<int>(*graph6, std::vector<int>{0, 1, 1, 4}, 5), 0);
+}
+
+// Time limits must be positive and finite
+TEST(CommandLineTest, TimeLimits)
+{
+    auto parse = [](std::string limit)
+    {
+        std::string program{"maxflow"}, option{"--time-limit=" + limit}, algorithm{"dinic"}, path{"graph.txt"};
+        char *argv[] = {program.data(), option.data(), algorithm.data(), path.data()};
+        CommandLineParser parser;
+        parser.parse(4, argv);
+        return parser.getOptions().timeLimit;
+    };
+    EXPECT_EQ(parse("0.5"), 0.5);
+    EXPECT_EQ(parse("1e10"), 1e10);
+    for (std::string limit : {"0", "-1", "inf", "nan", "1e400", "1s"})
+        EXPECT_THROW(parse(limit), std::invalid_argument) << limit;
+}
+
+// A solver can be run again, and leaves the capacities of the graph unchanged
+TEST_F(BasicTests, RepeatedSolveTests)
+{
+    const std::vector<int> capacities(graph1->capacities.begin(), graph1->capacities.end());
+
+    EdmondsKarp<int, int> edmondsKarp(*graph1);
+    Dinic<int, int> dinic(*graph1);
+    PushRelabel<int, int> pushRelabel(*graph1);
+    ParallelPushRelabel<int, int> parallelPushRelabel(*graph1, 2);
+    HighestLabelPushRelabel<int, int> highestLabel(*graph1);
+    CapacityScaling<int, int> capacityScaling(*graph1);
+    BoykovKolmogorov<int, int> boykovKolmogorov(*graph1);
+    Pseudoflow<int, int> pseudoflow(*graph1);
+
+    for (int run{0}; run < 2; ++run)
+    {
+        EXPECT_EQ(edmondsKarp.findMaxFlow(), 5);
+        EXPECT_EQ(dinic.findMaxFlow(), 5);
+        EXPECT_EQ(pushRelabel.findMaxFlow(), 5);
+        EXPECT_EQ(parallelPushRelabel.findMaxFlow(), 5);
+        EXPECT_EQ(highestLabel.findMaxFlow(), 5);
+        EXPECT_EQ(capacityScaling.findMaxFlow(), 5);
+        EXPECT_EQ(boykovKolmogorov.findMaxFlow(), 5);
+        EXPECT_EQ(pseudoflow.findMaxFlow(), 5);
+    }
+
+    EXPECT_EQ(std::vector<int>(graph1->capacities.begin(), graph1->capacities.end()), capacities);
+    EXPECT_EQ(findMinCut(*graph1, dinic.getResidualCapacities()), std::vector<bool>({true, true, true, false}));
+}
+
+// 64-bit vertex ids and capacities, with a max flow beyond 32 bits
+TEST(WideTypesTest, CapacitiesBeyond32Bits)
+{
+    GraphBuilder<long long, long long> builder(4, 0, 3);
+    builder.addArc(0, 1, 3000000000);
+    builder.addArc(0, 2, 2000000000);
+    builder.addArc(1, 2, 5000000000);
+    builder.addArc(1, 3, 2000000000);
+    builder.addArc(2, 3, 3000000000);
+    const Graph<long long, long long> graph = builder.build();
+    const long long expectedMaxFlow{5000000000};
+
+    EXPECT_EQ((EdmondsKarp<long long, long long>(graph).findMaxFlow()), expectedMaxFlow);
+    EXPECT_EQ((Dinic<long long, long long>(graph).findMaxFlow()), expectedMaxFlow);
+    EXPECT_EQ((PushRelabel<long long, long long>(graph).findMaxFlow()), expectedMaxFlow);
+    EXPECT_EQ((ParallelPushRelabel<long long, long long>(graph, 2).findMaxFlow()), expectedMaxFlow);
+    EXPECT_EQ((HighestLabelPushRelabel<long long, long long>(graph).findMaxFlow()), expectedMaxFlow);
+    EXPECT_EQ((CapacityScaling<long long, long long>(graph).findMaxFlow()), expectedMaxFlow);
+    EXPECT_EQ((BoykovKolmogorov<long long, long long>(graph).findMaxFlow()), expectedMaxFlow);
+    EXPECT_EQ((Pseudoflow<long long, long long>(graph).findMaxFlow()), expectedMaxFlow);
+}
+
+// Every instruction set the CPU has, against the scalar scans
+template <typename U>
+void checkArcScans(std::mt19937 &random)
+{
+    const int V{50};
+    const int E{200};
+    std::vector<int> heads(E);
+    std::vector<U> capacities(E);
+    std::vector<int> heights(V);
+    for (int e{0}; e < E; ++e)
+    {
+        heads[e] = random() % V;
+        capacities[e] = random() % 4 == 0 ? static_cast<U>(random() % 10) : 0;
+    }
+    for (int v{0}; v < V; ++v)
+        heights[v] = random() % 12;
+
+    const ArcScan::SimdLevel detected = ArcScan::simdLevel;
+    for (int level{0}; level <= static_cast<int>(detected); ++level)
+    {
+        ArcScan::simdLevel = static_cast<ArcScan::SimdLevel>(level);
+        for (int first{0}; first < E; first += 7)
+        {
+            for (int end : {first, first + 5, first + 16, first + 33, E})
+            {
+                end = std::min(end, E);
+                for (int height{0}; height < 12; ++height)
+                {
+                    EXPECT_EQ(ArcScan::findAdmissibleArc(heads.data(), capacities.data(), heights.data(), first, end, height),
+                              ArcScan::findAdmissibleArcScalar(heads.data(), capacities.data(), heights.data(), first, end, height));
+                }
+                EXPECT_EQ(ArcScan::minResidualHeight(heads.data(), capacities.data(), heights.data(), first, end, 10),
+                          ArcScan::minResidualHeightScalar(heads.data(), capacities.data(), heights.data(), first, end, 10));
+            }
+        }
+    }
+    ArcScan::simdLevel = detected;
+}
+
+TEST(ArcScanTest, VectorAndScalarScans)
+{
+    std::mt19937 random(11);
+    checkArcScans<int>(random);
+    checkArcScans<long long>(random);
+    checkArcScans<double>(random);
+
+    // Solvers on a graph with high degree vertices, with every instruction set
+    GraphBuilder<int, int> builder(102, 100, 101);
+    for (int u{0}; u < 100; ++u)
+    {
+        builder.addArc(100, u, random() % 50);
+        builder.addArc(u, 101, random() % 50);
+        for (int k{1}; k <= 40; ++k)
+            builder.addArc(u, (u + k) % 100, random() % 5);
+    }
+    const Graph<int, int> graph = builder.build();
+    Dinic<int, int> dinic(graph);
+    const int expected = dinic.findMaxFlow();
+
+    const ArcScan::SimdLevel detected = ArcScan::simdLevel;
+    for (int level{0}; level <= static_cast<int>(detected); ++level)
+    {
+        ArcScan::simdLevel = static_cast<ArcScan::SimdLevel>(level);
+        EXPECT_EQ((PushRelabel<int, int>(graph).findMaxFlow()), expected);
+        EXPECT_EQ((HighestLabelPushRelabel<int, int>(graph).findMaxFlow()), expected);
+    }
+    ArcScan::simdLevel = detected;
+}
+
+// The counters are only collected in builds with MAXFLOW_STATS
+TEST_F(BasicTests, StatsTests)
+{
+    EdmondsKarp<int, int> edmondsKarp(*graph1);
+    EXPECT_EQ(edmondsKarp.findMaxFlow(), 5);
+    EXPECT_EQ(edmondsKarp.getStats().augmentingPaths.value(), statsEnabled ? 3u : 0u);
+
+    Dinic<int, int> dinic(*graph5);
+    EXPECT_EQ(dinic.findMaxFlow(), 5);
+    EXPECT_EQ(dinic.getStats().phases.value(), statsEnabled ? 2u : 0u);
+    EXPECT_EQ(dinic.getStats().augmentingPaths.value(), statsEnabled ? 3u : 0u);
+
+    PushRelabel<int, int> pushRelabel(*graph6);
+    EXPECT_EQ(pushRelabel.findMaxFlow(), 0);
+    const Stats &stats = pushRelabel.getStats();
+    EXPECT_EQ(stats.relabels.value() > 0, statsEnabled);
+    EXPECT_EQ(stats.saturatingPushes.value() + stats.nonSaturatingPushes.value() > 0, statsEnabled);
+}
+
+// Solvers do not change the graph, so every file is read once and its graph
+// is shared by all tests.
 class GraphFromFileTest : public ::testing::TestWithParam<std::pair<std::string, int>>
 {
 protected:
-    std::ifstream fileStream;
-    std::unique_ptr<Graph<int, int>> graph;
+    std::shared_ptr<const Graph<int, int>> graph;
     int expectedMaxFlow;
+    std::string filePath;
 
     void SetUp() override
     {
+        static std::map<std::string, std::shared_ptr<const Graph<int, int>>> graphs;
+
         auto params = GetParam();
-        const std::string filePath = params.first;
+        filePath = params.first;
         expectedMaxFlow = params.second;
-        fileStream.open(filePath);
-        if (!fileStream)
-        {
-            GTEST_SKIP() << "Unable to open file: " << filePath;
-        }
-        graph = std::make_unique<Graph<int, int>>(readGraph<int, int, Edge>(fileStream));
-    }
 
-    void TearDown() override
-    {
-        if (fileStream)
+        auto &cached = graphs[filePath];
+        if (!cached)
         {
-            fileStream.close();
+            std::ifstream fileStream(filePath);
+            if (!fileStream)
+            {
+                GTEST_SKIP() << "Unable to open file: " << filePath;
+            }
+            cached = std::make_shared<const Graph<int, int>>(readGraph<int, int, Edge>(fileStream));
         }
+        graph = cached;
     }
 };
 
@@ -159,6 +1056,15 @@ TEST_P(GraphFromFileTest, EdmondsKarpTests)
     EXPECT_EQ(maxflow, expectedMaxFlow);
 }
 
+TEST_P(GraphFromFileTest, ReduceTests)
+{
+    GraphReduction<int, int> reduction;
+    const Graph<int, int> reduced = reduceGraph(*graph, reduction);
+    Dinic<int, int> dinic(reduced);
+    EXPECT_EQ(dinic.findMaxFlow() + reduction.flowOffset, expectedMaxFlow);
+    expectFlow(*graph, reduction.liftResidualCapacities(*graph, reduced, dinic.getResidualCapacities()), expectedMaxFlow);
+}
+
 TEST_P(GraphFromFileTest, DinicsTests)
 {
     Dinic<int, int> dinic(*graph);
@@ -173,6 +1079,92 @@ TEST_P(GraphFromFileTest, PushRelabelTests)
     EXPECT_EQ(maxflow, expectedMaxFlow);
 }
 
+TEST_P(GraphFromFileTest, ParallelPushRelabelSingleThreadTests)
+{
+    ParallelPushRelabel<int, int> parallelPushRelabel(*graph, 1);
+    int maxflow = parallelPushRelabel.findMaxFlow();
+    EXPECT_EQ(maxflow, expectedMaxFlow);
+}
+
+TEST_P(GraphFromFileTest, ParallelPushRelabelTests)
+{
+    ParallelPushRelabel<int, int> parallelPushRelabel(*graph, 4);
+    int maxflow = parallelPushRelabel.findMaxFlow();
+    EXPECT_EQ(maxflow, expectedMaxFlow);
+}
+
+TEST_P(GraphFromFileTest, HighestLabelPushRelabelTests)
+{
+    HighestLabelPushRelabel<int, int> highestLabel(*graph);
+    int maxflow = highestLabel.findMaxFlow();
+    EXPECT_EQ(maxflow, expectedMaxFlow);
+}
+
+TEST_P(GraphFromFileTest, HighestLabelPushRelabelPhaseOneTests)
+{
+    HighestLabelPushRelabel<int, int> highestLabel(*graph);
+    int maxflow = highestLabel.findMaxPreflow();
+    EXPECT_EQ(maxflow, expectedMaxFlow);
+
+    // The capacity of the cut in the graph equals the max flow
+    std::vector<bool> sourceSide = findMinCut(*graph, highestLabel.getResidualCapacities());
+    EXPECT_TRUE(sourceSide[graph->source]);
+    EXPECT_FALSE(sourceSide[graph->sink]);
+    EXPECT_EQ(cutCapacity(*graph, sourceSide), expectedMaxFlow);
+
+    highestLabel.convertToFlow();
+    EXPECT_EQ(findMinCut(*graph, highestLabel.getResidualCapacities()), sourceSide);
+}
+
+TEST_P(GraphFromFileTest, CapacityScalingTests)
+{
+    CapacityScaling<int, int> capacityScaling(*graph);
+    int maxflow = capacityScaling.findMaxFlow();
+    EXPECT_EQ(maxflow, expectedMaxFlow);
+}
+
+TEST_P(GraphFromFileTest, BoykovKolmogorovTests)
+{
+    BoykovKolmogorov<int, int> boykovKolmogorov(*graph);
+    int maxflow = boykovKolmogorov.findMaxFlow();
+    EXPECT_EQ(maxflow, expectedMaxFlow);
+}
+
+TEST_P(GraphFromFileTest, PseudoflowTests)
+{
+    Pseudoflow<int, int> pseudoflow(*graph);
+    int maxflow = pseudoflow.findMaxFlow();
+    EXPECT_EQ(maxflow, expectedMaxFlow);
+    EXPECT_EQ(cutCapacity(*graph, pseudoflow.minCut()), expectedMaxFlow);
+}
+
+// Solvers of every algorithm share the graph, from their own threads
+TEST_P(GraphFromFileTest, ConcurrentSolveTests)
+{
+    std::vector<int> maxflows(8);
+    std::vector<std::thread> threads;
+    threads.emplace_back([&]
+                         { maxflows[0] = EdmondsKarp<int, int>(*graph).findMaxFlow(); });
+    threads.emplace_back([&]
+                         { maxflows[1] = Dinic<int, int>(*graph).findMaxFlow(); });
+    threads.emplace_back([&]
+                         { maxflows[2] = PushRelabel<int, int>(*graph).findMaxFlow(); });
+    threads.emplace_back([&]
+                         { maxflows[3] = ParallelPushRelabel<int, int>(*graph, 2).findMaxFlow(); });
+    threads.emplace_back([&]
+                         { maxflows[4] = HighestLabelPushRelabel<int, int>(*graph).findMaxFlow(); });
+    threads.emplace_back([&]
+                         { maxflows[5] = CapacityScaling<int, int>(*graph).findMaxFlow(); });
+    threads.emplace_back([&]
+                         { maxflows[6] = BoykovKolmogorov<int, int>(*graph).findMaxFlow(); });
+    threads.emplace_back([&]
+                         { maxflows[7] = Pseudoflow<int, int>(*graph).findMaxFlow(); });
+    for (auto &thread : threads)
+        thread.join();
+
+    EXPECT_EQ(maxflows, std::vector<int>(8, expectedMaxFlow));
+}
+
 // Assuming you have a vector of file paths:
 std::string folder{"../../test/testdata/maxflowInstances/"};
 std::vector<std::pair<std::string, int>> files = {